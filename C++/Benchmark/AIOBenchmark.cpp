@@ -0,0 +1,536 @@
+/*
+  ==============================================================================
+
+    AIOBenchmark
+
+    Measures p50, p99, and max latency and calls per second for every entry
+    point in EchoAIOInterface.h, first from one thread and then with several
+    threads calling the same entry point at once. Results print as a table and
+    may also be written as JSON for regression tracking.
+
+    Runs against real hardware or the emulator (configure the emulator with
+    ECHO_AIO_EMULATOR_* environment variables, e.g. COMMANDMICROSECONDS).
+    Setters write back the value read at startup, so the device is left as
+    it was found.
+
+    Usage: AIOBenchmark [library path] [calls per entry point] [threads] [JSON output path]
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+
+/*
+    Fixture
+
+    The channels, module slots, and current control values that the entry points are called with
+*/
+struct Fixture
+{
+    int inputChannel = -1;
+    int outputChannel = -1;
+    int tedsChannel = -1;
+    int comboSlot = -1;
+    int tSlot = -1;
+
+    int inputGain = 0;
+    int constantCurrent = 0;
+    int outputGain = 0;
+    bool outputGainControl = false;
+    double outputLimitVolts = 0.0;
+    int auxOut = 0;
+    double overCurrentThreshold = 0.0;
+#if _WIN32
+    int bufferSize = 0;
+    int sampleRate = 0;
+#endif
+
+    void read(const AIOApi& api)
+    {
+        if (api.AIO_getNumInputChannels() > 0)
+        {
+            inputChannel = 0;
+            api.AIO_getInputGain(inputChannel, &inputGain);
+            api.AIO_getConstantCurrentState(inputChannel, &constantCurrent);
+        }
+        for (int channel = 0; channel < api.AIO_getNumInputChannels(); ++channel)
+        {
+            if (api.AIO_hasTEDS(channel))
+            {
+                tedsChannel = channel;
+                break;
+            }
+        }
+
+        if (api.AIO_getNumOutputChannels() > 0)
+        {
+            outputChannel = 0;
+            outputGainControl = 0 != api.AIO_hasOutputGainControl(outputChannel);
+            if (outputGainControl)
+            {
+                api.AIO_getOutputGain(outputChannel, &outputGain);
+            }
+            api.AIO_getOutputLimitVolts(outputChannel, &outputLimitVolts);
+        }
+
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            if (comboSlot < 0 && api.AIO_hasComboModule(slot))
+            {
+                comboSlot = slot;
+                api.AIO_getModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, &auxOut);
+                api.AIO_getModuleDoubleParameter(slot, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD, &overCurrentThreshold);
+            }
+            if (tSlot < 0 && api.AIO_hasTModule(slot))
+            {
+                tSlot = slot;
+            }
+        }
+
+#if _WIN32
+        bufferSize = api.AIO_getASIOPreferredBufferSize();
+        sampleRate = api.AIO_getSampleRate();
+#endif
+    }
+
+    /*
+        isAvailable
+
+        Returns false if the device has nothing for this entry point to act on (e.g. no AIO-C module)
+    */
+    bool isAvailable(int function) const
+    {
+        switch (function)
+        {
+        case AIOFunction_AIO_getInputGain:
+        case AIOFunction_AIO_setInputGain:
+        case AIOFunction_AIO_getConstantCurrentState:
+        case AIOFunction_AIO_setConstantCurrentState:
+            return inputChannel >= 0;
+
+        case AIOFunction_AIO_getTEDSProperties:
+            return tedsChannel >= 0;
+
+        case AIOFunction_AIO_getOutputGain:
+        case AIOFunction_AIO_setOutputGain:
+            return outputGainControl;
+
+        case AIOFunction_AIO_getOutputLimitVolts:
+        case AIOFunction_AIO_setOutputLimitVolts:
+            return outputChannel >= 0;
+
+        case AIOFunction_AIO_getModuleIntParameter:
+        case AIOFunction_AIO_setModuleIntParameter:
+        case AIOFunction_AIO_getModuleDoubleParameter:
+        case AIOFunction_AIO_setModuleDoubleParameter:
+            return comboSlot >= 0;
+
+        case AIOFunction_AIO_updateTDM:
+            return tSlot >= 0;
+        }
+        return true;
+    }
+};
+
+/*
+    callEntryPoint
+
+    Calls one library function with the fixture's arguments
+
+    Returns the function's status, or ECHO_AIO_OK for functions that do not return one
+*/
+static int callEntryPoint(const AIOApi& api, const Fixture& fixture, int function)
+{
+    char text[4096];
+    int intValue = 0;
+    double doubleValue = 0.0;
+    size_t bytesRequired = 0;
+
+    switch (function)
+    {
+    case AIOFunction_AIO_initialize:
+        api.AIO_initialize();
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_shutdown:
+        api.AIO_shutdown();
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getLibraryVersion:
+        api.AIO_getLibraryVersion(text, sizeof(text));
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_isAIOConnected:
+        api.AIO_isAIOConnected();
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getNumInputChannels:
+        api.AIO_getNumInputChannels();
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getNumOutputChannels:
+        api.AIO_getNumOutputChannels();
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_hasComboModule:
+        api.AIO_hasComboModule(0);
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_hasTModule:
+        api.AIO_hasTModule(0);
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getErrorString:
+        api.AIO_getErrorString(text, sizeof(text));
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_hasInputGainControl:
+        api.AIO_hasInputGainControl(0);
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getInputGain:
+        return api.AIO_getInputGain(fixture.inputChannel, &intValue);
+
+    case AIOFunction_AIO_setInputGain:
+        return api.AIO_setInputGain(fixture.inputChannel, fixture.inputGain);
+
+    case AIOFunction_AIO_hasConstantCurrentControl:
+        api.AIO_hasConstantCurrentControl(0);
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getConstantCurrentState:
+        return api.AIO_getConstantCurrentState(fixture.inputChannel, &intValue);
+
+    case AIOFunction_AIO_setConstantCurrentState:
+        return api.AIO_setConstantCurrentState(fixture.inputChannel, fixture.constantCurrent);
+
+    case AIOFunction_AIO_hasTEDS:
+        api.AIO_hasTEDS(0);
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getTEDSProperties:
+        return api.AIO_getTEDSProperties(fixture.tedsChannel, text, sizeof(text), &bytesRequired);
+
+    case AIOFunction_AIO_hasOutputGainControl:
+        api.AIO_hasOutputGainControl(0);
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getOutputGain:
+        return api.AIO_getOutputGain(fixture.outputChannel, &intValue);
+
+    case AIOFunction_AIO_setOutputGain:
+        return api.AIO_setOutputGain(fixture.outputChannel, fixture.outputGain);
+
+    case AIOFunction_AIO_hasOutputLimitControl:
+        api.AIO_hasOutputLimitControl(0);
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_getOutputLimitVolts:
+        return api.AIO_getOutputLimitVolts(fixture.outputChannel, &doubleValue);
+
+    case AIOFunction_AIO_setOutputLimitVolts:
+        return api.AIO_setOutputLimitVolts(fixture.outputChannel, fixture.outputLimitVolts);
+
+#if _WIN32
+    case AIOFunction_AIO_getASIOPreferredBufferSize:
+        api.AIO_getASIOPreferredBufferSize();
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_setASIOPreferredBufferSize:
+        return api.AIO_setASIOPreferredBufferSize(fixture.bufferSize);
+
+    case AIOFunction_AIO_getSampleRate:
+        api.AIO_getSampleRate();
+        return ECHO_AIO_OK;
+
+    case AIOFunction_AIO_setSampleRate:
+        return api.AIO_setSampleRate(fixture.sampleRate);
+#endif
+
+    case AIOFunction_AIO_getModuleIntParameter:
+        return api.AIO_getModuleIntParameter(fixture.comboSlot, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, &intValue);
+
+    case AIOFunction_AIO_setModuleIntParameter:
+        return api.AIO_setModuleIntParameter(fixture.comboSlot, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, fixture.auxOut);
+
+    case AIOFunction_AIO_getModuleDoubleParameter:
+        return api.AIO_getModuleDoubleParameter(fixture.comboSlot, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD, &doubleValue);
+
+    case AIOFunction_AIO_setModuleDoubleParameter:
+        return api.AIO_setModuleDoubleParameter(fixture.comboSlot, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD, fixture.overCurrentThreshold);
+
+    case AIOFunction_AIO_updateTDM:
+        return api.AIO_updateTDM(fixture.tSlot);
+    }
+    return ECHO_AIO_NOT_SUPPORTED;
+}
+
+struct Result
+{
+    int function = 0;
+    int threads = 1;
+    int errors = 0;
+    double callsPerSecond = 0.0;
+    LatencySummary latency;
+};
+
+/*
+    measure
+
+    Calls one entry point from each of threads at the same time, calls times per thread
+
+    Returns the combined latency distribution and throughput
+*/
+static Result measure(const AIOApi& api, const Fixture& fixture, int function, int calls, int threads)
+{
+    std::vector<std::vector<double>> samples(threads);
+    std::vector<int> errors(threads, 0);
+    std::atomic<int> ready { 0 };
+    std::atomic<bool> go { false };
+
+    auto worker = [&](int index)
+    {
+        auto& latencies = samples[index];
+        latencies.reserve(calls);
+        ready.fetch_add(1);
+        while (false == go.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        for (int i = 0; i < calls; ++i)
+        {
+            auto start = BenchmarkClock::now();
+            int status = callEntryPoint(api, fixture, function);
+            latencies.push_back(nanosecondsBetween(start, BenchmarkClock::now()));
+            if (ECHO_AIO_OK != status)
+            {
+                ++errors[index];
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int index = 1; index < threads; ++index)
+    {
+        workers.emplace_back(worker, index);
+    }
+    while (ready.load() < threads - 1)
+    {
+        std::this_thread::yield();
+    }
+
+    auto start = BenchmarkClock::now();
+    go.store(true, std::memory_order_release);
+    worker(0);
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+    double seconds = millisecondsBetween(start, BenchmarkClock::now()) / 1000.0;
+
+    Result result;
+    result.function = function;
+    result.threads = threads;
+    std::vector<double> all;
+    for (int index = 0; index < threads; ++index)
+    {
+        all.insert(all.end(), samples[index].begin(), samples[index].end());
+        result.errors += errors[index];
+    }
+    result.latency = LatencySummary::summarize(all);
+    result.callsPerSecond = seconds > 0.0 ? all.size() / seconds : 0.0;
+    return result;
+}
+
+static std::string escapeJSON(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if ('"' == c || '\\' == c)
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static void printResult(const Result& result)
+{
+    std::cout << std::left << std::setw(34) << getAIOFunctionName(result.function) << std::right <<
+        std::setw(8) << result.threads <<
+        std::setw(12) << std::fixed << std::setprecision(0) << result.latency.p50 <<
+        std::setw(12) << result.latency.p99 <<
+        std::setw(12) << result.latency.max <<
+        std::setw(14) << result.callsPerSecond <<
+        std::setw(8) << result.errors << std::endl;
+}
+
+static std::string formatJSON(const std::string& path, const std::string& libraryVersion, int calls, int threads,
+    const std::vector<Result>& results, const std::vector<int>& skipped)
+{
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(1);
+    json << "{\n";
+    json << "  \"library\": \"" << escapeJSON(path) << "\",\n";
+    json << "  \"libraryVersion\": \"" << escapeJSON(libraryVersion) << "\",\n";
+    json << "  \"callsPerThread\": " << calls << ",\n";
+    json << "  \"threads\": " << threads << ",\n";
+    json << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        json << "    { \"function\": \"" << getAIOFunctionName(result.function) << "\", \"threads\": " << result.threads <<
+            ", \"calls\": " << result.latency.count << ", \"errors\": " << result.errors <<
+            ", \"p50Ns\": " << result.latency.p50 << ", \"p99Ns\": " << result.latency.p99 <<
+            ", \"maxNs\": " << result.latency.max << ", \"meanNs\": " << result.latency.mean <<
+            ", \"callsPerSecond\": " << result.callsPerSecond << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ],\n";
+    json << "  \"skipped\": [";
+    for (size_t i = 0; i < skipped.size(); ++i)
+    {
+        json << (i ? ", " : "") << "\"" << getAIOFunctionName(skipped[i]) << "\"";
+    }
+    json << "]\n";
+    json << "}\n";
+    return json.str();
+}
+
+int main(int argc, const char* argv[])
+{
+    const char* path = argc > 1 ? argv[1] : AIOApi::defaultLibraryName;
+    int calls = argc > 2 ? std::atoi(argv[2]) : 2000;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 4;
+    const char* jsonPath = argc > 4 ? argv[4] : nullptr;
+
+    BenchmarkLibrary library(path);
+    if (false == library.isLoaded() || calls < 1 || threads < 1)
+    {
+        return 1;
+    }
+    const AIOApi& api = library.api;
+
+    api.AIO_initialize();
+    if (0 == api.AIO_isAIOConnected())
+    {
+        std::cout << "No AIO connected" << std::endl;
+        api.AIO_shutdown();
+        return 1;
+    }
+
+    Fixture fixture;
+    fixture.read(api);
+
+    std::cout << std::left << std::setw(34) << "Function" << std::right << std::setw(8) << "Threads" <<
+        std::setw(12) << "p50 ns" << std::setw(12) << "p99 ns" << std::setw(12) << "max ns" <<
+        std::setw(14) << "Calls/s" << std::setw(8) << "Errors" << std::endl;
+
+    //
+    // Every entry point other than AIO_initialize and AIO_shutdown, single-threaded and then contended
+    //
+    std::vector<Result> results;
+    std::vector<int> skipped;
+    for (int contended = 0; contended < 2; ++contended)
+    {
+        int threadCount = contended ? threads : 1;
+        if (contended && 1 == threads)
+        {
+            break;
+        }
+
+        for (int function = 0; function < AIOFunction_count; ++function)
+        {
+            if (AIOFunction_AIO_initialize == function || AIOFunction_AIO_shutdown == function)
+            {
+                continue;
+            }
+            if (false == fixture.isAvailable(function))
+            {
+                if (0 == contended)
+                {
+                    skipped.push_back(function);
+                }
+                continue;
+            }
+
+            results.push_back(measure(api, fixture, function, calls, threadCount));
+            printResult(results.back());
+        }
+    }
+
+    //
+    // AIO_shutdown and AIO_initialize run a full USB disconnect and rediscovery, so they are timed
+    // a few times from one thread only
+    //
+    int lifecycleCycles = std::min(calls, 5);
+    std::vector<double> shutdownTimes;
+    std::vector<double> initializeTimes;
+    for (int cycle = 0; cycle < lifecycleCycles; ++cycle)
+    {
+        auto start = BenchmarkClock::now();
+        api.AIO_shutdown();
+        auto middle = BenchmarkClock::now();
+        api.AIO_initialize();
+        shutdownTimes.push_back(nanosecondsBetween(start, middle));
+        initializeTimes.push_back(nanosecondsBetween(middle, BenchmarkClock::now()));
+    }
+
+    for (int function : { AIOFunction_AIO_initialize, AIOFunction_AIO_shutdown })
+    {
+        Result result;
+        result.function = function;
+        result.latency = LatencySummary::summarize(AIOFunction_AIO_initialize == function ? initializeTimes : shutdownTimes);
+        result.callsPerSecond = result.latency.mean > 0.0 ? 1.0e9 / result.latency.mean : 0.0;
+        results.push_back(result);
+        printResult(result);
+    }
+
+    for (int function : skipped)
+    {
+        std::cout << getAIOFunctionName(function) << " skipped; the device has nothing for it to act on" << std::endl;
+    }
+
+    if (jsonPath)
+    {
+        std::string json = formatJSON(path, api.libraryVersion, calls, threads, results, skipped);
+        if (std::string("-") == jsonPath)
+        {
+            std::cout << json;
+        }
+        else
+        {
+            std::ofstream file(jsonPath);
+            file << json;
+            if (false == file.good())
+            {
+                std::cout << "Unable to write " << jsonPath << std::endl;
+            }
+        }
+    }
+
+    api.AIO_shutdown();
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    BenchmarkUtilities - shared helpers for the benchmark programs
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../Common/AIOApi.h"
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+inline double millisecondsBetween(BenchmarkClock::time_point start, BenchmarkClock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+inline double nanosecondsBetween(BenchmarkClock::time_point start, BenchmarkClock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+/*
+    LatencySummary
+
+    Percentiles of a set of latency samples, in nanoseconds
+*/
+struct LatencySummary
+{
+    size_t count = 0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+
+    /*
+        summarize
+
+        Sorts samples in place
+
+        Returns the summary; all zero if there are no samples
+    */
+    static LatencySummary summarize(std::vector<double>& samples)
+    {
+        LatencySummary summary;
+        summary.count = samples.size();
+        if (samples.empty())
+        {
+            return summary;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&samples](double fraction)
+        {
+            size_t rank = static_cast<size_t>(fraction * samples.size() + 0.999999);
+            return samples[std::min(samples.size(), std::max<size_t>(rank, 1)) - 1];
+        };
+        summary.p50 = percentile(0.50);
+        summary.p99 = percentile(0.99);
+        summary.max = samples.back();
+
+        double total = 0.0;
+        for (double sample : samples)
+        {
+            total += sample;
+        }
+        summary.mean = total / samples.size();
+        return summary;
+    }
+};
+
+/*
+    BenchmarkLibrary
+
+    Loads the library named on the command line (or the platform default) and resolves an AIOApi table.
+    Check isLoaded before use; the library is unloaded when the object is destroyed.
+*/
+class BenchmarkLibrary
+{
+public:
+    explicit BenchmarkLibrary(const char* path)
+    {
+        handle = AIOApi::openLibrary(path);
+        if (nullptr == handle)
+        {
+            std::cout << "Unable to load Echo AIO library " << path << std::endl;
+            return;
+        }
+
+        std::string error;
+        if (false == api.resolve(handle, error))
+        {
+            std::cout << error << std::endl;
+            AIOApi::closeLibrary(handle);
+            handle = nullptr;
+        }
+    }
+
+    ~BenchmarkLibrary()
+    {
+        if (handle)
+        {
+            AIOApi::closeLibrary(handle);
+        }
+    }
+
+    BenchmarkLibrary(const BenchmarkLibrary&) = delete;
+    BenchmarkLibrary& operator=(const BenchmarkLibrary&) = delete;
+
+    bool isLoaded() const
+    {
+        return nullptr != handle;
+    }
+
+    /*
+        setEmulatorOption
+
+        Sets an option when the loaded library is the emulator (see C++/Emulator/EchoAIOEmulator.h);
+        does nothing for the real library.
+
+        Returns true if the emulator accepted the option
+    */
+    bool setEmulatorOption(const char* name, const std::string& value) const
+    {
+        using AIOEmulator_setOptionPointer = int (*)(const char*, const char*);
+        auto setOption = reinterpret_cast<AIOEmulator_setOptionPointer>(AIOApi::findSymbol(handle, "AIOEmulator_setOption"));
+        return setOption && ECHO_AIO_OK == setOption(name, value.c_str());
+    }
+
+    AIOLibraryHandle handle = nullptr;
+    AIOApi api;
+};
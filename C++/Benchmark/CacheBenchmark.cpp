@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    CacheBenchmark
+
+    Polls every channel control and the AIO-C module settings the way a UI
+    refresh does, once straight through the library and once through an
+    AIOControlCache, and reports the cost per getter. Live values (AUX IN,
+    measured current) are polled too; the cache passes those to the device.
+
+    Then re-applies an unchanged configuration before each of several test
+    steps, as a sequencer does, and reports the cost per setter with and
+    without redundant-write elision.
+
+    Usage: CacheBenchmark [library path] [refreshes] [emulated command us]
+
+  ==============================================================================
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOControlCache.h"
+
+/*
+    refresh
+
+    Reads what a UI panel displays
+
+    Returns the number of getter calls made
+*/
+template <typename Getters>
+static long refresh(Getters& getters, int inputs, int outputs, int comboSlot)
+{
+    long calls = 0;
+    int intValue = 0;
+    double doubleValue = 0.0;
+
+    for (int channel = 0; channel < inputs; ++channel)
+    {
+        getters.getInputGain(channel, &intValue);
+        getters.getConstantCurrentState(channel, &intValue);
+        calls += 2;
+    }
+
+    for (int channel = 0; channel < outputs; ++channel)
+    {
+        getters.getOutputLimitVolts(channel, &doubleValue);
+        ++calls;
+    }
+
+    if (comboSlot >= 0)
+    {
+        getters.getModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, &intValue);
+        getters.getModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_5VDC_ENABLE, &intValue);
+        getters.getModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, &intValue);
+        getters.getModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_TARGET_MILLIVOLTS, &intValue);
+        getters.getModuleDoubleParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD, &doubleValue);
+        getters.getModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_AUX_IN, &intValue);
+        getters.getModuleDoubleParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT, &doubleValue);
+        calls += 7;
+    }
+    return calls;
+}
+
+/*
+    configure
+
+    Writes a fixed configuration
+
+    Returns the number of setter calls made
+*/
+template <typename Setters>
+static long configure(Setters& setters, int inputs, int outputs, int comboSlot)
+{
+    long calls = 0;
+    for (int channel = 0; channel < inputs; ++channel)
+    {
+        setters.setInputGain(channel, 10);
+        setters.setConstantCurrentState(channel, 1);
+        calls += 2;
+    }
+
+    for (int channel = 0; channel < outputs; ++channel)
+    {
+        setters.setOutputLimitVolts(channel, 2.5);
+        ++calls;
+    }
+
+    if (comboSlot >= 0)
+    {
+        setters.setModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, 0x5a);
+        setters.setModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_5VDC_ENABLE, 1);
+        setters.setModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_TARGET_MILLIVOLTS, 3300);
+        setters.setModuleIntParameter(comboSlot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 1);
+        calls += 4;
+    }
+    return calls;
+}
+
+//
+// Adapts the library table to the getter and setter names used by AIOControlCache
+//
+struct DirectCalls
+{
+    const AIOApi& api;
+
+    int getInputGain(int channel, int* value) { return api.AIO_getInputGain(channel, value); }
+    int getConstantCurrentState(int channel, int* value) { return api.AIO_getConstantCurrentState(channel, value); }
+    int getOutputLimitVolts(int channel, double* value) { return api.AIO_getOutputLimitVolts(channel, value); }
+    int getModuleIntParameter(int slot, int parameter, int* value) { return api.AIO_getModuleIntParameter(slot, parameter, value); }
+    int getModuleDoubleParameter(int slot, int parameter, double* value) { return api.AIO_getModuleDoubleParameter(slot, parameter, value); }
+
+    int setInputGain(int channel, int value) { return api.AIO_setInputGain(channel, value); }
+    int setConstantCurrentState(int channel, int value) { return api.AIO_setConstantCurrentState(channel, value); }
+    int setOutputLimitVolts(int channel, double value) { return api.AIO_setOutputLimitVolts(channel, value); }
+    int setModuleIntParameter(int slot, int parameter, int value) { return api.AIO_setModuleIntParameter(slot, parameter, value); }
+};
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    int refreshes = argc > 2 ? std::atoi(argv[2]) : 20;
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 3 ? argv[3] : "125");
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    int inputs = api.AIO_getNumInputChannels();
+    int outputs = api.AIO_getNumOutputChannels();
+    int comboSlot = -1;
+    for (int slot = 0; slot < AIO_numModuleSlots && comboSlot < 0; ++slot)
+    {
+        comboSlot = api.AIO_hasComboModule(slot) ? slot : -1;
+    }
+
+    DirectCalls direct { api };
+    long directCalls = 0;
+    auto start = BenchmarkClock::now();
+    for (int i = 0; i < refreshes; ++i)
+    {
+        directCalls += refresh(direct, inputs, outputs, comboSlot);
+    }
+    double directTime = nanosecondsBetween(start, BenchmarkClock::now()) / directCalls;
+
+    //
+    // The first refresh fills the cache; later ones only go to the device for live values
+    //
+    AIOControlCache cache(api);
+    long cachedCalls = 0;
+    start = BenchmarkClock::now();
+    for (int i = 0; i < refreshes; ++i)
+    {
+        cachedCalls += refresh(cache, inputs, outputs, comboSlot);
+    }
+    double cachedTime = nanosecondsBetween(start, BenchmarkClock::now()) / cachedCalls;
+
+    //
+    // Re-apply the same configuration before every step
+    //
+    long directSets = 0;
+    start = BenchmarkClock::now();
+    for (int i = 0; i < refreshes; ++i)
+    {
+        directSets += configure(direct, inputs, outputs, comboSlot);
+    }
+    double directSetTime = nanosecondsBetween(start, BenchmarkClock::now()) / directSets;
+
+    //
+    // Elision needs a way to notice changes made by other clients: the broadcast, or else a maximum age
+    //
+    if (false == cache.startListening())
+    {
+        cache.setMaximumAge(1000);
+    }
+    cache.invalidate();
+    long cachedSets = 0;
+    start = BenchmarkClock::now();
+    for (int i = 0; i < refreshes; ++i)
+    {
+        cachedSets += configure(cache, inputs, outputs, comboSlot);
+    }
+    double cachedSetTime = nanosecondsBetween(start, BenchmarkClock::now()) / cachedSets;
+
+    api.AIO_shutdown();
+
+    std::cout << "Getters per refresh       " << directCalls / refreshes << std::endl;
+    std::cout << "Refreshes                 " << refreshes << std::endl;
+    std::cout << "Library getters           " << directTime / 1000.0 << " us/call" << std::endl;
+    std::cout << "AIOControlCache getters   " << cachedTime / 1000.0 << " us/call" << std::endl;
+    std::cout << "Speedup                   " << directTime / cachedTime << "x" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Setters per configure     " << directSets / refreshes << std::endl;
+    std::cout << "Library setters           " << directSetTime / 1000.0 << " us/call" << std::endl;
+    std::cout << "AIOControlCache setters   " << cachedSetTime / 1000.0 << " us/call" << std::endl;
+    std::cout << "Elided writes             " << cache.getElidedWriteCount() << " of " << cachedSets << std::endl;
+    return 0;
+}
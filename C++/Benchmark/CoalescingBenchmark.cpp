@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    CoalescingBenchmark
+
+    Emulates a control-change storm: another client turns the input gain of
+    channel 0 and toggles the AUX pins (looped back to AUX IN) as fast as it
+    can, and each change is broadcast to an AIOStateSnapshot. Reports the
+    device re-reads and the listener wake-ups, first with every broadcast
+    refreshing and every change delivered, then with a minimum refresh
+    interval and an AIOEventCoalescer window.
+
+    Usage: CoalescingBenchmark [library path] [emulated command us] [window ms] [storm ms]
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOEventCoalescer.h"
+#include "../Common/AIOStateSnapshot.h"
+
+struct Listener
+{
+    std::atomic<long> wakeups { 0 };
+    std::atomic<long> changes { 0 };
+
+    static void onEvent(const AIOEvent& event, void* context)
+    {
+        auto listener = static_cast<Listener*>(context);
+        listener->wakeups.fetch_add(1, std::memory_order_relaxed);
+        listener->changes.fetch_add(event.mergedCount, std::memory_order_relaxed);
+    }
+};
+
+struct StormResult
+{
+    long changes = 0;
+    uint64_t reads = 0;
+    long wakeups = 0;
+    long merged = 0;
+};
+
+static StormResult runStorm(const AIOApi& api, int windowMilliseconds, int stormMilliseconds)
+{
+    StormResult result;
+    Listener listener;
+    AIOStateSnapshot snapshot(api);
+    AIOEventCoalescer coalescer(windowMilliseconds);
+
+    coalescer.registerCallback(Listener::onEvent, AIO_EVENT_ALL, &listener);
+    snapshot.registerChangeCallback(AIOEventCoalescer::onEvent, AIO_EVENT_ALL, &coalescer);
+    snapshot.start(0, windowMilliseconds);
+
+    AIOControlState state;
+    snapshot.getStateSnapshot(&state);
+    uint64_t firstUpdate = state.updateCount;
+
+    //
+    // The other client; a broadcast follows each change, as the library sends one
+    //
+    auto end = BenchmarkClock::now() + std::chrono::milliseconds(stormMilliseconds);
+    for (long step = 0; BenchmarkClock::now() < end; ++step)
+    {
+        api.AIO_setInputGain(0, 0 == (step & 1) ? 10 : 100);
+        snapshot.refresh();
+        api.AIO_setModuleIntParameter(0, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, step & 0xff);
+        snapshot.refresh();
+        result.changes += 2;
+    }
+
+    snapshot.stop();
+    coalescer.flush();
+
+    snapshot.getStateSnapshot(&state);
+    result.reads = state.updateCount - firstUpdate;
+    result.wakeups = listener.wakeups.load();
+    result.merged = listener.changes.load();
+    return result;
+}
+
+static void printRow(const char* label, const StormResult& result)
+{
+    std::cout << label << "\t" << result.changes << "\t" << result.reads << "\t" << result.wakeups << "\t" << result.merged << "\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("auxLoopback", "1");
+    library.setEmulatorOption("commandMicroseconds", argc > 2 ? argv[2] : "100");
+    int windowMilliseconds = argc > 3 ? std::atoi(argv[3]) : 20;
+    int stormMilliseconds = argc > 4 ? std::atoi(argv[4]) : 1000;
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    StormResult uncoalesced = runStorm(api, 0, stormMilliseconds);
+    StormResult coalesced = runStorm(api, windowMilliseconds, stormMilliseconds);
+
+    api.AIO_shutdown();
+
+    std::cout << "Window\t\tChanges\tRe-reads\tWake-ups\tChanges reported\n";
+    printRow("none\t", uncoalesced);
+    std::cout << windowMilliseconds << " ms";
+    printRow("\t", coalesced);
+    return 0;
+}
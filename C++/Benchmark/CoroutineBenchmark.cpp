@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    CoroutineBenchmark
+
+    Runs many concurrent DUT steps (set a gain, read it back, read a TEDS)
+    first with one thread per step making blocking calls, then as C++20
+    coroutines on one AIOExecutor thread, and reports the time and the number
+    of threads each needed. Built as C++20.
+
+    Usage: CoroutineBenchmark [library path] [steps] [max in flight] [emulated command us]
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOCoroutine.h"
+
+static const int numInputs = 8;
+
+static int blockingStep(const AIOApi& api, int step)
+{
+    int channel = step % numInputs;
+    int gain = 0;
+    size_t bytesRequired = 0;
+    int errors = ECHO_AIO_OK != api.AIO_setInputGain(channel, step & 1 ? 10 : 1);
+    errors += ECHO_AIO_OK != api.AIO_getInputGain(channel, &gain);
+    errors += ECHO_AIO_OK != api.AIO_getTEDSProperties(step % 2, nullptr, 0, &bytesRequired);
+    return errors;
+}
+
+static AIOTask<void> coroutineStep(AIOCoroutines& aio, int step, int& errors)
+{
+    int channel = step % numInputs;
+    errors += ECHO_AIO_OK != (co_await aio.setInputGain(channel, step & 1 ? 10 : 1)).status;
+    errors += ECHO_AIO_OK != (co_await aio.getInputGain(channel)).status;
+    errors += ECHO_AIO_OK != (co_await aio.readTEDS(step % 2)).status;
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    int steps = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int maxInFlight = argc > 3 ? std::atoi(argv[3]) : 8;
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 4 ? argv[4] : "250");
+    library.setEmulatorOption("inputChannels", std::to_string(numInputs));
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    //
+    // One thread per step
+    //
+    std::vector<int> threadErrors(steps);
+    auto start = BenchmarkClock::now();
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(steps);
+        for (int step = 0; step < steps; ++step)
+        {
+            threads.emplace_back([&api, &threadErrors, step]() { threadErrors[step] = blockingStep(api, step); });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    double threadTime = millisecondsBetween(start, BenchmarkClock::now());
+    int errors = 0;
+    for (int stepErrors : threadErrors)
+    {
+        errors += stepErrors;
+    }
+
+    //
+    // Every step a coroutine on one executor thread
+    //
+    int coroutineErrors = 0;
+    start = BenchmarkClock::now();
+    {
+        AIOExecutor executor;
+        AIOCommandQueue queue(api, maxInFlight);
+        AIOCoroutines aio(executor, queue);
+        for (int step = 0; step < steps; ++step)
+        {
+            executor.spawn(coroutineStep(aio, step, coroutineErrors));
+        }
+        executor.run();
+    }
+    double coroutineTime = millisecondsBetween(start, BenchmarkClock::now());
+
+    api.AIO_shutdown();
+
+    //
+    // The executor thread, the queue's workers, and its safety-lane worker
+    //
+    int coroutineThreads = 2 + std::max(maxInFlight, 1);
+
+    std::cout << "Steps                     " << steps << std::endl;
+    std::cout << "Thread per step           " << threadTime << " ms, " << steps << " threads, " << errors << " errors" << std::endl;
+    std::cout << "Coroutines                " << coroutineTime << " ms, " << coroutineThreads << " threads, " << coroutineErrors << " errors" << std::endl;
+    return 0;
+}
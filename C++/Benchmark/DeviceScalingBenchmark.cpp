@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    DeviceScalingBenchmark
+
+    Drives 1 to N AIO units from one process, one thread per unit, and reports
+    the combined command throughput. Each unit is a separate library instance
+    (see AIOApi::openLibraryInstance), so on Linux the emulator can stand in
+    for every unit.
+
+    Usage: DeviceScalingBenchmark [library path] [max units] [emulated command us] [ms per run]
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIODevice.h"
+
+struct EmulatorSettings
+{
+    std::string commandMicroseconds;
+};
+
+static void prepareEmulatedUnit(AIOLibraryHandle handle, int index, void* context)
+{
+    using AIOEmulator_setOptionPointer = int (*)(const char*, const char*);
+    auto setOption = reinterpret_cast<AIOEmulator_setOptionPointer>(AIOApi::findSymbol(handle, "AIOEmulator_setOption"));
+    if (nullptr == setOption)
+    {
+        return;
+    }
+
+    auto settings = static_cast<const EmulatorSettings*>(context);
+    setOption("discoveryMilliseconds", "0");
+    setOption("commandMicroseconds", settings->commandMicroseconds.c_str());
+    setOption("serialNumber", std::to_string(100001 + index).c_str());
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string path = argc > 1 ? argv[1] : AIOApi::defaultLibraryName;
+    int maxUnits = argc > 2 ? std::atoi(argv[2]) : 4;
+    EmulatorSettings settings { argc > 3 ? argv[3] : "200" };
+    int runMilliseconds = argc > 4 ? std::atoi(argv[4]) : 1000;
+
+    std::cout << "Units\tCommands/s\tScaling\tSerial numbers" << std::endl;
+
+    double singleUnitRate = 0.0;
+    for (int units = 1; units <= maxUnits; ++units)
+    {
+        AIODeviceList list;
+        std::string error;
+        std::vector<std::string> paths(units, path);
+        if (list.enumerateDevices(paths, error, prepareEmulatedUnit, &settings) != units)
+        {
+            std::cout << "Found " << list.getNumDevices() << " of " << units << " units" << std::endl << error;
+            return 1;
+        }
+
+        std::atomic<bool> running { true };
+        std::vector<long> counts(units, 0);
+        std::vector<std::thread> threads;
+        for (int index = 0; index < units; ++index)
+        {
+            threads.emplace_back([&, index]()
+                {
+                    const AIOApi& api = list.getDevice(index)->api();
+                    long count = 0;
+                    int gain = 0;
+                    while (running.load(std::memory_order_relaxed))
+                    {
+                        api.AIO_setInputGain(0, 0 == (count & 1) ? 10 : 1);
+                        api.AIO_getInputGain(0, &gain);
+                        count += 2;
+                    }
+                    counts[index] = count;
+                });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(runMilliseconds));
+        running = false;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        long total = 0;
+        for (auto count : counts)
+        {
+            total += count;
+        }
+
+        double rate = total * 1000.0 / runMilliseconds;
+        if (1 == units)
+        {
+            singleUnitRate = rate;
+        }
+
+        std::string serialNumbers;
+        for (auto serialNumber : list.getSerialNumbers())
+        {
+            serialNumbers += std::to_string(serialNumber) + " ";
+        }
+
+        std::cout << units << "\t" << rate << "\t\t" << rate / singleUnitRate << "x\t" << serialNumbers << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    DispatchBenchmark
+
+    Compares the cost of looking up a library function next to each call with
+    calling through a resolved AIOApi table.
+
+    Usage: DispatchBenchmark [library path] [iterations]
+
+  ==============================================================================
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include "BenchmarkUtilities.h"
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    long iterations = argc > 2 ? std::atol(argv[2]) : 1000000;
+    const AIOApi& api = library.api;
+    auto handle = library.handle;
+
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    api.AIO_initialize();
+
+    //
+    // Per-call lookup, as in the original example code
+    //
+    int sink = 0;
+    auto start = BenchmarkClock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        using AIO_hasInputGainControlPointer = int (*)(int);
+        auto pAIO_hasInputGainControl = reinterpret_cast<AIO_hasInputGainControlPointer>(AIOApi::findSymbol(handle, "AIO_hasInputGainControl"));
+        if (pAIO_hasInputGainControl)
+        {
+            sink += pAIO_hasInputGainControl(0);
+        }
+    }
+    auto lookupTime = nanosecondsBetween(start, BenchmarkClock::now()) / iterations;
+
+    //
+    // Resolved table
+    //
+    start = BenchmarkClock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        sink += api.AIO_hasInputGainControl(0);
+    }
+    auto tableTime = nanosecondsBetween(start, BenchmarkClock::now()) / iterations;
+
+    api.AIO_shutdown();
+
+    std::cout << "Library version         " << api.libraryVersion << std::endl;
+    std::cout << "Iterations              " << iterations << std::endl;
+    std::cout << "Per-call lookup         " << lookupTime << " ns/call" << std::endl;
+    std::cout << "Resolved AIOApi table   " << tableTime << " ns/call" << std::endl;
+    std::cout << "Lookup overhead         " << lookupTime - tableTime << " ns/call" << std::endl;
+
+    return sink < 0 ? 1 : 0;
+}
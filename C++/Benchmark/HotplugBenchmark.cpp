@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    HotplugBenchmark
+
+    Unplugs and replugs an emulated AIO, and swaps the module in slot 1, and
+    measures how long it takes to bring the topology up to date after each
+    change: first with a full AIOTopology::query, as a polling loop would,
+    and then with AIOHotplugMonitor, which re-queries only what changed.
+
+    Usage: HotplugBenchmark [library path] [emulated command us] [emulated TEDS read us] [cycles]
+
+  ==============================================================================
+*/
+
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOHotplug.h"
+
+//
+// Records when the monitor delivers an event of the awaited type
+//
+struct EventWaiter
+{
+    std::mutex lock;
+    std::condition_variable delivered;
+    int awaitedType = 0;
+    bool seen = false;
+    BenchmarkClock::time_point time;
+
+    static void onEvent(const AIOEvent& event, void* context)
+    {
+        auto waiter = static_cast<EventWaiter*>(context);
+        std::lock_guard<std::mutex> guard(waiter->lock);
+        if (event.type == waiter->awaitedType)
+        {
+            waiter->seen = true;
+            waiter->time = BenchmarkClock::now();
+            waiter->delivered.notify_all();
+        }
+    }
+
+    void expect(int type)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        awaitedType = type;
+        seen = false;
+    }
+
+    BenchmarkClock::time_point wait()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        delivered.wait(guard, [this]() { return seen; });
+        return time;
+    }
+};
+
+//
+// Option changes for one cycle: the event each produces and the label it is reported under
+//
+struct Change
+{
+    const char* label;
+    const char* name;
+    const char* value;
+    int eventType;
+};
+
+static const Change changes[] =
+{
+    { "unplug", "connected", "0", AIO_EVENT_CONNECTION },
+    { "replug", "connected", "1", AIO_EVENT_CONNECTION },
+    { "module out", "modules", "C-", AIO_EVENT_MODULE },
+    { "module in", "modules", "CT", AIO_EVENT_MODULE }
+};
+
+static void printRow(const char* label, std::vector<double>& nanoseconds)
+{
+    LatencySummary summary = LatencySummary::summarize(nanoseconds);
+    std::cout << label << "\t" << summary.p50 / 1e6 << " ms\t" << summary.max / 1e6 << " ms\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 2 ? argv[2] : "500");
+    library.setEmulatorOption("tedsMicroseconds", argc > 3 ? argv[3] : "20000");
+    int cycles = argc > 4 ? std::atoi(argv[4]) : 20;
+
+    //
+    // The changes are made through emulator options; with the real library nothing would ever change
+    //
+    if (false == library.setEmulatorOption("connected", "1") || false == library.setEmulatorOption("modules", "CT"))
+    {
+        std::cout << "HotplugBenchmark needs the emulator's connected and modules options" << std::endl;
+        return 1;
+    }
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    std::vector<double> full[4];
+    std::vector<double> incremental[4];
+
+    //
+    // Full re-enumeration after every change
+    //
+    for (int cycle = 0; cycle < cycles; ++cycle)
+    {
+        for (int index = 0; index < 4; ++index)
+        {
+            library.setEmulatorOption(changes[index].name, changes[index].value);
+            auto start = BenchmarkClock::now();
+            AIOTopology topology = AIOTopology::query(api);
+            full[index].push_back(nanosecondsBetween(start, BenchmarkClock::now()));
+        }
+    }
+
+    //
+    // AIOHotplugMonitor, woken by check after every change
+    //
+    {
+        AIOHotplugMonitor monitor(api);
+        EventWaiter waiter;
+        monitor.registerCallback(EventWaiter::onEvent, AIO_EVENT_ALL, &waiter);
+        monitor.start(0);
+
+        for (int cycle = 0; cycle < cycles; ++cycle)
+        {
+            for (int index = 0; index < 4; ++index)
+            {
+                library.setEmulatorOption(changes[index].name, changes[index].value);
+                waiter.expect(changes[index].eventType);
+                auto start = BenchmarkClock::now();
+                monitor.check();
+                incremental[index].push_back(nanosecondsBetween(start, waiter.wait()));
+            }
+        }
+
+        monitor.stop();
+    }
+
+    api.AIO_shutdown();
+
+    std::cout << "Change\t\tp50\t\tmax\n";
+    for (int index = 0; index < 4; ++index)
+    {
+        std::cout << changes[index].label << "\n";
+        printRow("  full query", full[index]);
+        printRow("  monitor", incremental[index]);
+    }
+    return 0;
+}
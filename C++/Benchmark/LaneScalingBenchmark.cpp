@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    LaneScalingBenchmark
+
+    Drives one AIO from 1, 2, 4, and 8 threads through AIOLanes and reports
+    the combined command throughput. Thread 0 streams the measured current
+    from the AIO-C module in slot 0, thread 1 reconfigures the AIO-T module in
+    slot 1 and calls AIO_updateTDM, and the others set and read input gains
+    and output limits. Each run uses AIOLanes both with a single lane (one
+    client-side mutex) and with a lane per channel and slot, so the two are
+    compared under the same emulator mode: once with the emulator serializing
+    every command behind one lock and once with a command lane per channel
+    group and slot.
+
+    Usage: LaneScalingBenchmark [library path] [emulated command us] [ms per run]
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOLanes.h"
+
+//
+// One thread's share of the work
+//
+static long runWorkload(AIOLanes& lanes, int index, const std::atomic<bool>& running)
+{
+    long count = 0;
+    int intValue = 0;
+    double doubleValue = 0.0;
+    while (running.load(std::memory_order_relaxed))
+    {
+        switch (index % 4)
+        {
+        case 0:
+            lanes.getModuleDoubleParameter(0, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT, &doubleValue);
+            count += 1;
+            break;
+
+        case 1:
+        {
+            AIOLanes::Lock guard = lanes.lockModuleSlot(1);
+            lanes.setModuleIntParameter(1, AIO_T_MODULE_PARAMETER_CLOCK_SINK, count & 1);
+            lanes.updateTDM(1);
+            count += 2;
+            break;
+        }
+
+        case 2:
+            lanes.setInputGain(index / 4, 0 == (count & 1) ? 10 : 1);
+            lanes.getInputGain(index / 4, &intValue);
+            count += 2;
+            break;
+
+        case 3:
+            lanes.setOutputLimitVolts(index / 4, 0 == (count & 1) ? 2.5 : 5.0);
+            lanes.getOutputLimitVolts(index / 4, &doubleValue);
+            count += 2;
+            break;
+        }
+    }
+    return count;
+}
+
+//
+// Runs the workload on 1, 2, 4, and 8 threads and prints one row per thread count
+//
+static void runScaling(const AIOApi& api, AIOLanes::LaneMode laneMode, const std::string& device, const char* client,
+    int runMilliseconds)
+{
+    AIOLanes lanes(api, laneMode);
+    double singleThreadRate = 0.0;
+    for (int numThreads = 1; numThreads <= 8; numThreads *= 2)
+    {
+        std::atomic<bool> running { true };
+        std::vector<long> counts(numThreads, 0);
+        std::vector<std::thread> threads;
+        for (int index = 0; index < numThreads; ++index)
+        {
+            threads.emplace_back([&, index]() { counts[index] = runWorkload(lanes, index, running); });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(runMilliseconds));
+        running = false;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        long total = 0;
+        for (auto count : counts)
+        {
+            total += count;
+        }
+
+        double rate = total * 1000.0 / runMilliseconds;
+        if (1 == numThreads)
+        {
+            singleThreadRate = rate;
+        }
+        std::cout << device << "\t" << (device.size() < 8 ? "\t" : "") << client << "\t" << numThreads << "\t" << rate << "\t\t" <<
+            rate / singleThreadRate << "x" << std::endl;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 2 ? argv[2] : "200");
+    int runMilliseconds = argc > 3 ? std::atoi(argv[3]) : 1000;
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    const char* modes[] = { "1", "2" };
+    const char* names[] = { "one lock", "lanes" };
+    std::cout << "Device\t\tClient\tThreads\tCommands/s\tScaling" << std::endl;
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        //
+        // The real library runs once, as it is
+        //
+        bool emulated = library.setEmulatorOption("commandLanes", modes[mode]);
+        if (false == emulated && mode > 0)
+        {
+            break;
+        }
+        std::string name = emulated ? names[mode] : "library";
+
+        //
+        // One client-side mutex, then a lane per channel and slot, against the same device behavior
+        //
+        runScaling(api, AIOLanes::AIO_SINGLE_LANE, name, "mutex", runMilliseconds);
+        runScaling(api, AIOLanes::AIO_LANE_PER_TARGET, name, "lanes", runMilliseconds);
+    }
+
+    api.AIO_shutdown();
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    OverCurrentBenchmark
+
+    Shorts the variable DC supply of the emulated AIO-C module in slot 0 over
+    and over, and measures how long it takes to see the trip and to turn the
+    supply off: through AIOStateSnapshot's periodic refresh with the
+    application turning the supply off, through AIOOverCurrentMonitor with the
+    application turning it off, and through AIOOverCurrentMonitor with the
+    AIO_OVER_CURRENT_DISABLE_POWER policy.
+
+    Usage: OverCurrentBenchmark [library path] [emulated command us] [trips]
+
+  ==============================================================================
+*/
+
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOOverCurrent.h"
+#include "../Common/AIOStateSnapshot.h"
+
+//
+// Plays the application: records the trip and, unless the policy already did, turns the supply off
+//
+struct Responder
+{
+    const AIOApi* api = nullptr;
+    bool disableInCallback = true;
+
+    std::mutex lock;
+    std::condition_variable done;
+    bool poweredOff = false;
+    int64_t tripTimestamp = 0;
+    int64_t offTimestamp = 0;
+
+    static void onEvent(const AIOEvent& event, void* context)
+    {
+        auto responder = static_cast<Responder*>(context);
+        if (AIO_EVENT_OVER_CURRENT == event.type && 1 == event.intValue)
+        {
+            {
+                std::lock_guard<std::mutex> guard(responder->lock);
+                responder->tripTimestamp = event.timestamp;
+            }
+            if (responder->disableInCallback)
+            {
+                responder->api->AIO_setModuleIntParameter(0, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 0);
+                responder->powerOff(AIOEvent::now());
+            }
+        }
+        else if (AIO_EVENT_MODULE_PARAMETER == event.type && AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE == event.parameter &&
+            0 == event.intValue && false == responder->disableInCallback)
+        {
+            responder->powerOff(event.timestamp);
+        }
+    }
+
+    void powerOff(int64_t timestamp)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (false == poweredOff)
+        {
+            poweredOff = true;
+            offTimestamp = timestamp;
+            done.notify_all();
+        }
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        poweredOff = false;
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [this]() { return poweredOff; });
+    }
+};
+
+struct TripResults
+{
+    std::vector<double> detect;
+    std::vector<double> off;
+};
+
+//
+// Enables the supply, shorts it, waits for the responder, then removes the short and clears the condition
+//
+static void runTrips(BenchmarkLibrary& library, Responder& responder, int trips, TripResults& results)
+{
+    const AIOApi& api = library.api;
+    for (int trip = 0; trip < trips; ++trip)
+    {
+        api.AIO_setModuleIntParameter(0, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        responder.reset();
+        int64_t start = AIOEvent::now();
+        library.setEmulatorOption("shortCircuit", "1");
+        responder.wait();
+
+        results.detect.push_back(static_cast<double>(responder.tripTimestamp - start));
+        results.off.push_back(static_cast<double>(responder.offTimestamp - start));
+
+        //
+        // Long enough for the snapshot's periodic refresh to see the condition cleared
+        //
+        library.setEmulatorOption("shortCircuit", "0");
+        api.AIO_setModuleIntParameter(0, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+}
+
+static void printRow(const char* label, TripResults& results)
+{
+    LatencySummary detect = LatencySummary::summarize(results.detect);
+    LatencySummary off = LatencySummary::summarize(results.off);
+    std::cout << label << "\t" << detect.p50 / 1e6 << "\t" << detect.max / 1e6 << "\t" << off.p50 / 1e6 << "\t" << off.max / 1e6 << "\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 2 ? argv[2] : "500");
+    int trips = argc > 3 ? std::atoi(argv[3]) : 20;
+
+    //
+    // The trips are caused through an emulator option; with the real library no trip would ever come
+    //
+    if (false == library.setEmulatorOption("shortCircuit", "0"))
+    {
+        std::cout << "OverCurrentBenchmark needs the emulator's shortCircuit option" << std::endl;
+        return 1;
+    }
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    TripResults snapshotResults;
+    TripResults monitorResults;
+    TripResults policyResults;
+
+    {
+        Responder responder;
+        responder.api = &api;
+        AIOStateSnapshot snapshot(api);
+        snapshot.registerChangeCallback(Responder::onEvent, AIO_EVENT_OVER_CURRENT, &responder);
+        snapshot.start(100);
+        runTrips(library, responder, trips, snapshotResults);
+        snapshot.stop();
+    }
+
+    {
+        Responder responder;
+        responder.api = &api;
+        AIOOverCurrentMonitor monitor(api);
+        monitor.registerCallback(Responder::onEvent, AIO_EVENT_OVER_CURRENT, &responder);
+        monitor.start();
+        runTrips(library, responder, trips, monitorResults);
+        monitor.stop();
+    }
+
+    {
+        Responder responder;
+        responder.disableInCallback = false;
+        AIOOverCurrentMonitor monitor(api, AIO_OVER_CURRENT_DISABLE_POWER);
+        monitor.registerCallback(Responder::onEvent, AIO_EVENT_OVER_CURRENT | AIO_EVENT_MODULE_PARAMETER, &responder);
+        monitor.start();
+        runTrips(library, responder, trips, policyResults);
+        monitor.stop();
+    }
+
+    api.AIO_shutdown();
+
+    std::cout << "Milliseconds after the short\tdetect p50\tmax\toff p50\tmax\n";
+    printRow("snapshot, 100 ms refresh\t", snapshotResults);
+    printRow("monitor, 5 ms poll\t\t", monitorResults);
+    printRow("monitor, disable policy\t\t", policyResults);
+    return 0;
+}
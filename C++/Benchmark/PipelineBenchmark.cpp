@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    PipelineBenchmark
+
+    One control thread configures and reads back eight input channels and both
+    module slots, first with blocking library calls and then through an
+    AIOCommandQueue with 1 to N commands in flight.
+
+    Usage: PipelineBenchmark [library path] [max in flight] [rounds] [emulated command us]
+
+  ==============================================================================
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOCommandQueue.h"
+
+static const int numInputs = 8;
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    int maxInFlight = argc > 2 ? std::atoi(argv[2]) : 8;
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 20;
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 4 ? argv[4] : "250");
+    library.setEmulatorOption("inputChannels", std::to_string(numInputs));
+    library.setEmulatorOption("modules", "CT");
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    //
+    // Blocking calls: every command waits for the previous round trip
+    //
+    int errors = 0;
+    long commands = 0;
+    auto start = BenchmarkClock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (int channel = 0; channel < numInputs; ++channel)
+        {
+            int gain = 0;
+            errors += ECHO_AIO_OK != api.AIO_setInputGain(channel, round & 1 ? 10 : 1);
+            errors += ECHO_AIO_OK != api.AIO_getInputGain(channel, &gain);
+            commands += 2;
+        }
+        int value = 0;
+        errors += ECHO_AIO_OK != api.AIO_setModuleIntParameter(0, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, round & 0xff);
+        errors += ECHO_AIO_OK != api.AIO_getModuleIntParameter(0, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, &value);
+        errors += ECHO_AIO_OK != api.AIO_setModuleIntParameter(1, AIO_T_MODULE_PARAMETER_CLOCK_SINK, round & 1);
+        errors += ECHO_AIO_OK != api.AIO_updateTDM(1);
+        commands += 4;
+    }
+    double blockingTime = millisecondsBetween(start, BenchmarkClock::now());
+
+    std::cout << "In flight\tms\tCommands/s\tSpeedup\tErrors" << std::endl;
+    std::cout << "blocking\t" << blockingTime << "\t" << commands * 1000.0 / blockingTime << "\t1\t" << errors << std::endl;
+
+    for (int inFlight = 1; inFlight <= maxInFlight; inFlight *= 2)
+    {
+        AIOCommandQueue queue(api, inFlight);
+        std::vector<std::future<AIOCommandResult>> results;
+        results.reserve(commands);
+
+        start = BenchmarkClock::now();
+        for (int round = 0; round < rounds; ++round)
+        {
+            for (int channel = 0; channel < numInputs; ++channel)
+            {
+                results.push_back(queue.setInputGainAsync(channel, round & 1 ? 10 : 1));
+                results.push_back(queue.getInputGainAsync(channel));
+            }
+            results.push_back(queue.setModuleIntParameterAsync(0, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, round & 0xff));
+            results.push_back(queue.getModuleIntParameterAsync(0, AIO_COMBO_MODULE_PARAMETER_AUX_OUT));
+            results.push_back(queue.setModuleIntParameterAsync(1, AIO_T_MODULE_PARAMETER_CLOCK_SINK, round & 1));
+            results.push_back(queue.updateTDMAsync(1));
+        }
+        queue.waitUntilIdle();
+        double time = millisecondsBetween(start, BenchmarkClock::now());
+
+        errors = 0;
+        for (auto& result : results)
+        {
+            errors += ECHO_AIO_OK != result.get().status;
+        }
+        std::cout << inFlight << "\t\t" << time << "\t" << commands * 1000.0 / time << "\t" << blockingTime / time << "\t" << errors << std::endl;
+    }
+
+    api.AIO_shutdown();
+    return 0;
+}
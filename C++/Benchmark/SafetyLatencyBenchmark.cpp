@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    SafetyLatencyBenchmark
+
+    Keeps an AIOCommandQueue saturated with TEDS reads, input gain changes,
+    and AIO-T settings, and meanwhile turns off the variable DC supply and
+    reads the over current condition of the AIO-C module in slot 0. Reports
+    the worst-case latency of those safety commands with and without the
+    queue's safety lane.
+
+    Usage: SafetyLatencyBenchmark [library path] [samples] [backlog] [emulated TEDS us]
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOCommandQueue.h"
+
+static void onBulkDone(const AIOCommandResult&, void* context)
+{
+    static_cast<std::atomic<int>*>(context)->fetch_sub(1, std::memory_order_relaxed);
+}
+
+//
+// Queues bulk work until backlog calls are outstanding
+//
+static void topUp(AIOCommandQueue& queue, std::atomic<int>& outstanding, int backlog, long& submitted)
+{
+    while (outstanding.load(std::memory_order_relaxed) < backlog)
+    {
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        switch (submitted++ % 4)
+        {
+        case 0:
+            queue.getTEDSPropertiesAsync(submitted & 1, onBulkDone, &outstanding);
+            break;
+
+        case 1:
+            queue.setInputGainAsync(2 + (submitted & 1), submitted & 2 ? 10 : 1, onBulkDone, &outstanding);
+            break;
+
+        case 2:
+            queue.setModuleIntParameterAsync(1, AIO_T_MODULE_PARAMETER_CLOCK_SINK, submitted & 1, onBulkDone, &outstanding);
+            break;
+
+        case 3:
+            queue.setModuleIntParameterAsync(0, AIO_COMBO_MODULE_PARAMETER_AUX_OUT, submitted & 0xff, onBulkDone, &outstanding);
+            break;
+        }
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    int samples = argc > 2 ? std::atoi(argv[2]) : 100;
+    int backlog = argc > 3 ? std::atoi(argv[3]) : 32;
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", "200");
+    library.setEmulatorOption("tedsMicroseconds", argc > 4 ? argv[4] : "20000");
+    library.setEmulatorOption("commandLanes", "2");
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    std::cout << "Queue\t\tp50 ms\tp99 ms\tmax ms\tErrors" << std::endl;
+    for (auto mode : { AIOCommandQueue::AIO_NO_SAFETY_LANE, AIOCommandQueue::AIO_SAFETY_LANE })
+    {
+        std::atomic<int> outstanding { 0 };
+        long submitted = 0;
+        std::vector<double> latencies;
+        int errors = 0;
+        {
+            AIOCommandQueue queue(api, 4, mode);
+            for (int sample = 0; sample < samples; ++sample)
+            {
+                topUp(queue, outstanding, backlog, submitted);
+
+                auto start = BenchmarkClock::now();
+                auto result = 0 == (sample & 1) ?
+                    queue.setModuleIntParameterAsync(0, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 0) :
+                    queue.getModuleIntParameterAsync(0, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION);
+                errors += ECHO_AIO_OK != result.get().status;
+                latencies.push_back(millisecondsBetween(start, BenchmarkClock::now()));
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+
+        LatencySummary summary = LatencySummary::summarize(latencies);
+        std::cout << (AIOCommandQueue::AIO_SAFETY_LANE == mode ? "safety lane" : "no safety lane") << "\t" <<
+            summary.p50 << "\t" << summary.p99 << "\t" << summary.max << "\t" << errors << std::endl;
+    }
+
+    api.AIO_shutdown();
+    return 0;
+}
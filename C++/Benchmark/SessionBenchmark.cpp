@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    SessionBenchmark
+
+    Measures open/close churn, as when several plugins in one host each start
+    and stop their use of the library. It compares calling AIO_initialize and
+    AIO_shutdown for every open with sharing a reference-counted AIOSession.
+
+    Usage: SessionBenchmark [library path] [cycles] [emulated discovery ms]
+
+  ==============================================================================
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOSession.h"
+
+int main(int argc, const char* argv[])
+{
+    const char* path = argc > 1 ? argv[1] : AIOApi::defaultLibraryName;
+    int cycles = argc > 2 ? std::atoi(argv[2]) : 20;
+    const char* discoveryMilliseconds = argc > 3 ? argv[3] : "50";
+
+    //
+    // Global AIO_initialize / AIO_shutdown for every plugin open and close; the library stays
+    // loaded so the sessions below share the same emulator options
+    //
+    BenchmarkLibrary library(path);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+    library.setEmulatorOption("discoveryMilliseconds", discoveryMilliseconds);
+
+    auto globalStart = BenchmarkClock::now();
+    for (int i = 0; i < cycles; ++i)
+    {
+        library.api.AIO_initialize();
+        library.api.AIO_shutdown();
+    }
+    double globalTime = millisecondsBetween(globalStart, BenchmarkClock::now());
+
+    //
+    // Reference-counted sessions; one long-lived session keeps the library open
+    // while the other plugins open and close theirs
+    //
+    std::string error;
+    auto first = BenchmarkClock::now();
+    AIOSession host = AIOSession::open(path, error);
+    if (false == host.isOpen())
+    {
+        std::cout << error << std::endl;
+        return 1;
+    }
+    double firstOpenTime = millisecondsBetween(first, BenchmarkClock::now());
+
+    long sessionCycles = static_cast<long>(cycles) * 10000;
+    auto start = BenchmarkClock::now();
+    for (long i = 0; i < sessionCycles; ++i)
+    {
+        AIOSession plugin = AIOSession::open(path, error);
+        plugin.close();
+    }
+    double sessionTime = nanosecondsBetween(start, BenchmarkClock::now());
+
+    int gain = 0;
+    int status = host.api().AIO_getInputGain(0, &gain);
+    host.close();
+
+    std::cout << "Emulated discovery                 " << discoveryMilliseconds << " ms" << std::endl;
+    std::cout << "AIO_initialize/AIO_shutdown cycle  " << globalTime / cycles << " ms" << std::endl;
+    std::cout << "First AIOSession open              " << firstOpenTime << " ms" << std::endl;
+    std::cout << "Later AIOSession open/close cycle  " << sessionTime / sessionCycles << " ns" << std::endl;
+    std::cout << "Host session still usable          status " << status << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    SnapshotBenchmark
+
+    Compares what an audio callback pays to learn the input gain, CCP state,
+    and output limit: three library getters against one
+    AIOStateSnapshot::getStateSnapshot copy. The snapshot is read again while
+    another thread keeps changing gains through the snapshot's setters, so
+    the reads retry against a busy writer.
+
+    Usage: SnapshotBenchmark [library path] [reads] [emulated command us]
+
+  ==============================================================================
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOStateSnapshot.h"
+
+static void print(const char* name, std::vector<double>& samples)
+{
+    LatencySummary summary = LatencySummary::summarize(samples);
+    std::cout << name << summary.p50 << "\t" << summary.p99 << "\t" << summary.max << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    int reads = argc > 2 ? std::atoi(argv[2]) : 100000;
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 3 ? argv[3] : "125");
+
+    const AIOApi& api = library.api;
+    api.AIO_initialize();
+
+    std::vector<double> samples;
+    samples.reserve(reads);
+
+    //
+    // Library getters, as a callback would have to call them
+    //
+    int getterReads = std::min(reads, 200);
+    int gain = 0;
+    int enabled = 0;
+    double limitVolts = 0.0;
+    for (int i = 0; i < getterReads; ++i)
+    {
+        auto start = BenchmarkClock::now();
+        api.AIO_getInputGain(0, &gain);
+        api.AIO_getConstantCurrentState(0, &enabled);
+        api.AIO_getOutputLimitVolts(0, &limitVolts);
+        samples.push_back(nanosecondsBetween(start, BenchmarkClock::now()));
+    }
+
+    std::cout << "Read\t\t\tp50 ns\tp99 ns\tmax ns" << std::endl;
+    print("Library getters\t\t", samples);
+
+    AIOStateSnapshot snapshot(api);
+    snapshot.start();
+    AIOControlState state;
+
+    samples.clear();
+    for (int i = 0; i < reads; ++i)
+    {
+        auto start = BenchmarkClock::now();
+        snapshot.getStateSnapshot(&state);
+        samples.push_back(nanosecondsBetween(start, BenchmarkClock::now()));
+    }
+    print("Snapshot\t\t", samples);
+
+    //
+    // A writer publishing as fast as the setters return
+    //
+    library.setEmulatorOption("commandMicroseconds", "0");
+    std::atomic<bool> running { true };
+    long writes = 0;
+    std::thread writer([&]()
+        {
+            while (running.load(std::memory_order_relaxed))
+            {
+                snapshot.setInputGain(0, 0 == (writes & 1) ? 10 : 1);
+                ++writes;
+            }
+        });
+
+    samples.clear();
+    for (int i = 0; i < reads; ++i)
+    {
+        auto start = BenchmarkClock::now();
+        snapshot.getStateSnapshot(&state);
+        samples.push_back(nanosecondsBetween(start, BenchmarkClock::now()));
+    }
+    running = false;
+    writer.join();
+    print("Snapshot, busy writer\t", samples);
+    std::cout << "Writes during reads\t" << writes << std::endl;
+
+    snapshot.stop();
+    api.AIO_shutdown();
+    return 0;
+}
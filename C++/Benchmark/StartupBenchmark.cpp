@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    StartupBenchmark
+
+    Measures station startup time with a blocking AIO_initialize and with
+    AIOAsyncInitializer, while the application does its own startup work.
+
+    Usage: StartupBenchmark [library path] [application startup ms] [emulated discovery ms]
+
+  ==============================================================================
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOAsyncInitializer.h"
+
+static void doApplicationStartup(int milliseconds)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    int applicationMilliseconds = argc > 2 ? std::atoi(argv[2]) : 1000;
+    if (argc > 3)
+    {
+        library.setEmulatorOption("discoveryMilliseconds", argv[3]);
+    }
+
+    const AIOApi& api = library.api;
+    int gain = 0;
+
+    //
+    // Blocking: discovery, then application startup, then the first call
+    //
+    auto start = BenchmarkClock::now();
+    api.AIO_initialize();
+    auto initializeReturned = BenchmarkClock::now();
+    doApplicationStartup(applicationMilliseconds);
+    int blockingStatus = api.AIO_getInputGain(0, &gain);
+    auto blockingReady = BenchmarkClock::now();
+    api.AIO_shutdown();
+
+    //
+    // Asynchronous: discovery overlaps application startup
+    //
+    double asyncReturn = 0.0;
+    double asyncReady = 0.0;
+    int tryStatus = ECHO_AIO_OK;
+    int asyncStatus = ECHO_AIO_OK;
+    {
+        AIOAsyncInitializer initializer(api);
+
+        auto asyncStart = BenchmarkClock::now();
+        initializer.initializeAsync();
+        asyncReturn = millisecondsBetween(asyncStart, BenchmarkClock::now());
+
+        tryStatus = initializer.waitUntilInitialized(AIOAsyncInitializer::AIO_TRY);
+
+        doApplicationStartup(applicationMilliseconds);
+        asyncStatus = initializer.waitUntilInitialized();
+        if (ECHO_AIO_OK == asyncStatus)
+        {
+            asyncStatus = api.AIO_getInputGain(0, &gain);
+        }
+        asyncReady = millisecondsBetween(asyncStart, BenchmarkClock::now());
+    }
+    api.AIO_shutdown();
+
+    std::cout << "Application startup work          " << applicationMilliseconds << " ms" << std::endl;
+    std::cout << "Blocking AIO_initialize returned  " << millisecondsBetween(start, initializeReturned) << " ms" << std::endl;
+    std::cout << "Blocking first call completed     " << millisecondsBetween(start, blockingReady) << " ms (status " << blockingStatus << ")" << std::endl;
+    std::cout << "initializeAsync returned          " << asyncReturn << " ms" << std::endl;
+    std::cout << "Try-mode call during discovery    status " << tryStatus << std::endl;
+    std::cout << "Async first call completed        " << asyncReady << " ms (status " << asyncStatus << ")" << std::endl;
+
+    return 0;
+}
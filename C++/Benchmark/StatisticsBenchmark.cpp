@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    StatisticsBenchmark
+
+    Measures what AIOInstrumentation adds to each call, for a call that stays
+    in the library and for one that sends a USB command, from one thread and
+    from several at once. Prints the collected statistics as JSON.
+
+    Usage: StatisticsBenchmark [library path] [iterations] [threads] [emulated command us]
+
+  ==============================================================================
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "BenchmarkUtilities.h"
+#include "../Common/AIOInstrumentation.h"
+
+static double measure(const AIOApi& api, bool command, long iterations, int threads)
+{
+    auto run = [&api, command, iterations]()
+    {
+        int gain = 0;
+        for (long i = 0; i < iterations; ++i)
+        {
+            if (command)
+            {
+                api.AIO_getInputGain(0, &gain);
+            }
+            else
+            {
+                api.AIO_hasInputGainControl(0);
+            }
+        }
+    };
+
+    auto start = BenchmarkClock::now();
+    std::vector<std::thread> workers;
+    for (int index = 1; index < threads; ++index)
+    {
+        workers.emplace_back(run);
+    }
+    run();
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+    return nanosecondsBetween(start, BenchmarkClock::now()) / iterations;
+}
+
+int main(int argc, const char* argv[])
+{
+    BenchmarkLibrary library(argc > 1 ? argv[1] : AIOApi::defaultLibraryName);
+    if (false == library.isLoaded())
+    {
+        return 1;
+    }
+
+    long iterations = argc > 2 ? std::atol(argv[2]) : 1000000;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 4;
+    library.setEmulatorOption("discoveryMilliseconds", "0");
+    library.setEmulatorOption("commandMicroseconds", argc > 4 ? argv[4] : "0");
+
+    const AIOApi& plain = library.api;
+    AIOApi instrumented = AIOInstrumentation::instrument(plain);
+    plain.AIO_initialize();
+
+    std::cout << "Call\t\t\t\tThreads\tPlain ns/call\tInstrumented ns/call" << std::endl;
+    for (int command = 0; command < 2; ++command)
+    {
+        for (int threadCount : { 1, threads })
+        {
+            double plainTime = measure(plain, command, iterations, threadCount);
+            double instrumentedTime = measure(instrumented, command, iterations, threadCount);
+            std::cout << (command ? "AIO_getInputGain\t\t" : "AIO_hasInputGainControl\t\t") << threadCount << "\t" <<
+                plainTime << "\t\t" << instrumentedTime << std::endl;
+        }
+    }
+
+    size_t bytesRequired = 0;
+    AIOInstrumentation::getStatistics(nullptr, 0, &bytesRequired);
+    std::vector<char> json(bytesRequired);
+    if (ECHO_AIO_OK == AIOInstrumentation::getStatistics(json.data(), json.size(), &bytesRequired))
+    {
+        std::cout << json.data() << std::endl;
+    }
+
+    plain.AIO_shutdown();
+    return 0;
+}
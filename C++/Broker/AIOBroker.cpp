@@ -0,0 +1,544 @@
+/*
+  ==============================================================================
+
+    AIOBroker - shares one AIO between many processes (Linux and macOS)
+
+    The broker owns the library and the USB connection. Clients send library
+    calls over a Unix domain socket (see AIOBrokerClient.h); the broker also
+    publishes the current control state in a shared memory segment that
+    read-mostly clients map and read without a system call.
+
+    Usage: AIOBroker [library path] [socket path] [shared memory name] [refresh ms]
+
+    The published state is read again from the device each time the library
+    broadcasts AIO_notificationString (macOS), at most every 100 ms. Pass a
+    refresh interval to also read it periodically; the default of 0 does not,
+    since a full read is dozens of USB commands that hold up client calls.
+
+    To try it with the emulator on one machine:
+
+        ./AIOBroker ./EchoAIOInterface.so &
+        ./AIOBrokerMonitor
+
+  ==============================================================================
+*/
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <vector>
+#include "AIOBrokerProtocol.h"
+#include "../Common/AIONotification.h"
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stop(int)
+{
+    running = 0;
+}
+
+/*
+    Broker
+
+    Runs every request on the broker thread, one at a time, and keeps the published state in step with
+    successful set calls. A refresh on each broadcast, or an optional periodic one, picks up changes made by
+    other clients of the library, from the front panel, or by the hardware.
+*/
+struct Broker
+{
+    const AIOApi& api;
+    AIOBrokerSharedMemory* shared;
+    AIOControlState state;
+
+    void publish()
+    {
+        ++state.updateCount;
+        uint32_t copy = 1 - shared->current.load(std::memory_order_relaxed);
+        shared->state[copy].write(state);
+        shared->current.store(copy, std::memory_order_release);
+    }
+
+    void refresh()
+    {
+        uint64_t updateCount = state.updateCount;
+        state = AIOControlState::query(api);
+        state.updateCount = updateCount;
+        publish();
+    }
+
+    void copyText(const char* text, const AIOBrokerRequest& request, AIOBrokerResponse& response, std::vector<char>& reply)
+    {
+        size_t length = std::strlen(text) + 1;
+        response.bytesRequired = length;
+        response.textBytes = static_cast<uint32_t>(std::min<size_t>(length, request.bufferBytes));
+        reply.assign(text, text + response.textBytes);
+        if (response.textBytes)
+        {
+            reply.back() = 0;
+        }
+    }
+
+    void execute(const AIOBrokerRequest& request, AIOBrokerResponse& response, std::vector<char>& reply)
+    {
+        std::memset(&response, 0, sizeof(response));
+        reply.clear();
+
+        int channel = request.channel;
+        int parameter = request.parameter;
+        bool changed = false;
+
+        switch (request.function)
+        {
+        case AIOFunction_AIO_initialize:
+        case AIOFunction_AIO_shutdown:
+            //
+            // The broker owns the library lifetime
+            //
+            break;
+
+        case AIOFunction_AIO_getLibraryVersion:
+        case AIOFunction_AIO_getErrorString:
+        {
+            std::vector<char> text(std::max<uint32_t>(std::min(request.bufferBytes, AIOBrokerMaxTextBytes), 1));
+            if (AIOFunction_AIO_getLibraryVersion == request.function)
+                api.AIO_getLibraryVersion(text.data(), text.size());
+            else
+                api.AIO_getErrorString(text.data(), text.size());
+            text.back() = 0;
+            copyText(text.data(), request, response, reply);
+            break;
+        }
+
+        case AIOFunction_AIO_isAIOConnected: response.status = api.AIO_isAIOConnected(); break;
+        case AIOFunction_AIO_getNumInputChannels: response.status = api.AIO_getNumInputChannels(); break;
+        case AIOFunction_AIO_getNumOutputChannels: response.status = api.AIO_getNumOutputChannels(); break;
+        case AIOFunction_AIO_hasComboModule: response.status = api.AIO_hasComboModule(channel); break;
+        case AIOFunction_AIO_hasTModule: response.status = api.AIO_hasTModule(channel); break;
+        case AIOFunction_AIO_hasInputGainControl: response.status = api.AIO_hasInputGainControl(channel); break;
+        case AIOFunction_AIO_hasConstantCurrentControl: response.status = api.AIO_hasConstantCurrentControl(channel); break;
+        case AIOFunction_AIO_hasTEDS: response.status = api.AIO_hasTEDS(channel); break;
+        case AIOFunction_AIO_hasOutputGainControl: response.status = api.AIO_hasOutputGainControl(channel); break;
+        case AIOFunction_AIO_hasOutputLimitControl: response.status = api.AIO_hasOutputLimitControl(channel); break;
+
+        case AIOFunction_AIO_getInputGain: response.status = api.AIO_getInputGain(channel, &response.intValue); break;
+        case AIOFunction_AIO_getConstantCurrentState: response.status = api.AIO_getConstantCurrentState(channel, &response.intValue); break;
+        case AIOFunction_AIO_getOutputGain: response.status = api.AIO_getOutputGain(channel, &response.intValue); break;
+        case AIOFunction_AIO_getOutputLimitVolts: response.status = api.AIO_getOutputLimitVolts(channel, &response.doubleValue); break;
+        case AIOFunction_AIO_getModuleIntParameter: response.status = api.AIO_getModuleIntParameter(channel, parameter, &response.intValue); break;
+        case AIOFunction_AIO_getModuleDoubleParameter: response.status = api.AIO_getModuleDoubleParameter(channel, parameter, &response.doubleValue); break;
+
+        case AIOFunction_AIO_getTEDSProperties:
+        {
+            size_t bytesRequired = 0;
+            std::vector<char> text(std::min(request.bufferBytes, AIOBrokerMaxTextBytes));
+            response.status = api.AIO_getTEDSProperties(channel, text.size() ? text.data() : nullptr, text.size(), &bytesRequired);
+            response.bytesRequired = bytesRequired;
+            if (ECHO_AIO_OK == response.status && text.size())
+            {
+                response.textBytes = static_cast<uint32_t>(std::min(bytesRequired, text.size()));
+                reply.assign(text.begin(), text.begin() + response.textBytes);
+            }
+            break;
+        }
+
+        case AIOFunction_AIO_setInputGain:
+            response.status = api.AIO_setInputGain(channel, request.intValue);
+            if (ECHO_AIO_OK == response.status && channel >= 0 && channel < state.numInputChannels)
+            {
+                state.inputGain[channel] = request.intValue;
+                changed = true;
+            }
+            break;
+
+        case AIOFunction_AIO_setConstantCurrentState:
+            response.status = api.AIO_setConstantCurrentState(channel, request.intValue);
+            if (ECHO_AIO_OK == response.status && channel >= 0 && channel < state.numInputChannels)
+            {
+                state.constantCurrent[channel] = request.intValue;
+                changed = true;
+            }
+            break;
+
+        case AIOFunction_AIO_setOutputGain:
+            response.status = api.AIO_setOutputGain(channel, request.intValue);
+            break;
+
+        case AIOFunction_AIO_setOutputLimitVolts:
+            response.status = api.AIO_setOutputLimitVolts(channel, request.doubleValue);
+            if (ECHO_AIO_OK == response.status && channel >= 0 && channel < state.numOutputChannels)
+            {
+                state.outputLimitVolts[channel] = request.doubleValue;
+                changed = true;
+            }
+            break;
+
+        case AIOFunction_AIO_setModuleIntParameter:
+            response.status = api.AIO_setModuleIntParameter(channel, parameter, request.intValue);
+            if (ECHO_AIO_OK == response.status && channel >= 0 && channel < AIO_numModuleSlots && AIOControlState::getParameterIndex(parameter) >= 0)
+            {
+                state.modules[channel].intParameters[AIOControlState::getParameterIndex(parameter)] = request.intValue;
+                changed = true;
+            }
+            break;
+
+        case AIOFunction_AIO_setModuleDoubleParameter:
+            response.status = api.AIO_setModuleDoubleParameter(channel, parameter, request.doubleValue);
+            if (ECHO_AIO_OK == response.status && channel >= 0 && channel < AIO_numModuleSlots && AIOControlState::getParameterIndex(parameter) >= 0)
+            {
+                state.modules[channel].doubleParameters[AIOControlState::getParameterIndex(parameter)] = request.doubleValue;
+                changed = true;
+            }
+            break;
+
+        case AIOFunction_AIO_updateTDM:
+            response.status = api.AIO_updateTDM(channel);
+            break;
+
+        default:
+            response.status = ECHO_AIO_NOT_SUPPORTED;
+            break;
+        }
+
+        if (changed)
+        {
+            publish();
+        }
+    }
+};
+
+/*
+    Client
+
+    One connected socket, non-blocking. Requests are read into input as they arrive and run once complete;
+    responses wait in output until the socket takes them, so a slow or stalled client never holds up the
+    broker. No more requests are read from a client until its output has been written.
+*/
+struct Client
+{
+    int socket;
+    std::vector<char> input;        // bytes of a request not yet complete
+    std::vector<char> output;       // responses not yet written
+    size_t written = 0;
+};
+
+static bool setNonBlocking(int descriptor)
+{
+    int flags = fcntl(descriptor, F_GETFL, 0);
+    return flags >= 0 && 0 == fcntl(descriptor, F_SETFL, flags | O_NONBLOCK);
+}
+
+//
+// Returns false if the client must be closed
+//
+static bool writeOutput(Client& client)
+{
+    while (client.written < client.output.size())
+    {
+        ssize_t count = ::write(client.socket, client.output.data() + client.written, client.output.size() - client.written);
+        if (count > 0)
+        {
+            client.written += static_cast<size_t>(count);
+            continue;
+        }
+        if (count < 0 && EINTR == errno)
+        {
+            continue;
+        }
+        return count < 0 && (EAGAIN == errno || EWOULDBLOCK == errno);
+    }
+
+    client.output.clear();
+    client.written = 0;
+    return true;
+}
+
+//
+// Reads what the client has sent, runs each complete request, and starts writing the responses; returns false
+// if the client must be closed
+//
+static bool readRequests(Broker& broker, Client& client, std::vector<char>& reply)
+{
+    char buffer[4096];
+    ssize_t count = ::read(client.socket, buffer, sizeof(buffer));
+    if (count < 0)
+    {
+        return EINTR == errno || EAGAIN == errno || EWOULDBLOCK == errno;
+    }
+    if (0 == count)
+    {
+        return false;
+    }
+    client.input.insert(client.input.end(), buffer, buffer + count);
+
+    size_t offset = 0;
+    while (client.input.size() - offset >= sizeof(AIOBrokerRequest))
+    {
+        AIOBrokerRequest request;
+        AIOBrokerResponse response;
+        std::memcpy(&request, client.input.data() + offset, sizeof(request));
+        offset += sizeof(request);
+
+        broker.execute(request, response, reply);
+        auto responseBytes = reinterpret_cast<const char*>(&response);
+        client.output.insert(client.output.end(), responseBytes, responseBytes + sizeof(response));
+        client.output.insert(client.output.end(), reply.begin(), reply.end());
+    }
+    client.input.erase(client.input.begin(), client.input.begin() + offset);
+
+    return writeOutput(client);
+}
+
+//
+// Broadcasts arrive on the listener thread; a byte down this pipe wakes the broker thread's poll
+//
+static int wakePipe[2] = { -1, -1 };
+
+static void onNotification(void*)
+{
+    char byte = 0;
+    ssize_t written = ::write(wakePipe[1], &byte, 1);
+    (void) written;
+}
+
+static AIOBrokerSharedMemory* createSharedMemory(const char* name)
+{
+    shm_unlink(name);
+    int descriptor = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (descriptor < 0)
+    {
+        return nullptr;
+    }
+
+    void* memory = MAP_FAILED;
+    if (0 == ftruncate(descriptor, sizeof(AIOBrokerSharedMemory)))
+    {
+        memory = mmap(nullptr, sizeof(AIOBrokerSharedMemory), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    close(descriptor);
+
+    if (MAP_FAILED == memory)
+    {
+        shm_unlink(name);
+        return nullptr;
+    }
+
+    auto shared = new (memory) AIOBrokerSharedMemory;
+    shared->version = AIOBrokerVersion;
+    shared->magic = AIOBrokerMagic;
+    shared->running.store(1, std::memory_order_release);
+    return shared;
+}
+
+static int createListeningSocket(const char* path)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(address.sun_path))
+    {
+        return -1;
+    }
+    std::strcpy(address.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        return -1;
+    }
+
+    unlink(path);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 16) < 0)
+    {
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+int main(int argc, const char* argv[])
+{
+    const char* libraryPath = argc > 1 ? argv[1] : AIOApi::defaultLibraryName;
+    const char* socketPath = argc > 2 ? argv[2] : AIOBrokerDefaultSocketPath;
+    const char* sharedMemoryName = argc > 3 ? argv[3] : AIOBrokerDefaultSharedMemoryName;
+    int refreshMilliseconds = argc > 4 ? std::atoi(argv[4]) : 0;
+    const auto broadcastInterval = std::chrono::milliseconds(100);
+
+    auto handle = AIOApi::openLibrary(libraryPath);
+    if (nullptr == handle)
+    {
+        std::cout << "Unable to load Echo AIO library " << libraryPath << std::endl;
+        return 1;
+    }
+
+    AIOApi api;
+    std::string error;
+    if (false == api.resolve(handle, error))
+    {
+        std::cout << error << std::endl;
+        return 1;
+    }
+
+    auto shared = createSharedMemory(sharedMemoryName);
+    if (nullptr == shared)
+    {
+        std::cout << "Unable to create shared memory " << sharedMemoryName << std::endl;
+        return 1;
+    }
+
+    int listener = createListeningSocket(socketPath);
+    if (listener < 0)
+    {
+        std::cout << "Unable to listen on " << socketPath << std::endl;
+        shm_unlink(sharedMemoryName);
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    api.AIO_initialize();
+
+    Broker broker { api, shared, {} };
+    broker.refresh();
+    std::cout << "AIO broker running; library " << api.libraryVersion << ", socket " << socketPath << ", shared memory " << sharedMemoryName << std::endl;
+
+    AIONotificationListener notifications;
+    if (0 == pipe(wakePipe) && setNonBlocking(wakePipe[0]) && setNonBlocking(wakePipe[1]))
+    {
+        notifications.start(onNotification, nullptr);
+    }
+
+    //
+    // descriptors holds the listening socket, the wake pipe, then one entry per client
+    //
+    std::vector<Client> clients;
+    std::vector<pollfd> descriptors;
+    std::vector<char> reply;
+    using Clock = std::chrono::steady_clock;
+    auto lastRefresh = Clock::now();
+    auto nextRefresh = Clock::time_point::max();
+    if (refreshMilliseconds > 0)
+    {
+        nextRefresh = lastRefresh + std::chrono::milliseconds(refreshMilliseconds);
+    }
+    bool broadcastPending = false;
+
+    while (running)
+    {
+        auto refreshAt = nextRefresh;
+        if (broadcastPending)
+        {
+            refreshAt = std::min(refreshAt, lastRefresh + broadcastInterval);
+        }
+        int timeout = -1;
+        if (Clock::time_point::max() != refreshAt)
+        {
+            timeout = static_cast<int>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(refreshAt - Clock::now()).count(), 0));
+        }
+
+        descriptors.assign({ { listener, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } });
+        for (const auto& client : clients)
+        {
+            descriptors.push_back({ client.socket, static_cast<short>(client.output.empty() ? POLLIN : POLLOUT), 0 });
+        }
+
+        int ready = poll(descriptors.data(), descriptors.size(), timeout);
+        if (ready < 0 && EINTR != errno)
+        {
+            break;
+        }
+
+        if (ready > 0 && (descriptors[1].revents & POLLIN))
+        {
+            char bytes[64];
+            while (::read(wakePipe[0], bytes, sizeof(bytes)) > 0)
+            {
+            }
+            broadcastPending = true;
+        }
+
+        auto now = Clock::now();
+        if (now >= nextRefresh || (broadcastPending && now >= lastRefresh + broadcastInterval))
+        {
+            broker.refresh();
+            broadcastPending = false;
+            lastRefresh = Clock::now();
+            if (refreshMilliseconds > 0)
+            {
+                nextRefresh = lastRefresh + std::chrono::milliseconds(refreshMilliseconds);
+            }
+        }
+
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        for (size_t index = clients.size(); index-- > 0;)
+        {
+            short events = descriptors[index + 2].revents;
+            if (0 == events)
+            {
+                continue;
+            }
+
+            bool open = 0 == (events & (POLLERR | POLLNVAL));
+            if (open && (events & POLLOUT))
+            {
+                open = writeOutput(clients[index]);
+            }
+            else if (open && (events & (POLLIN | POLLHUP)))
+            {
+                open = readRequests(broker, clients[index], reply);
+            }
+
+            if (false == open)
+            {
+                close(clients[index].socket);
+                clients.erase(clients.begin() + index);
+            }
+        }
+
+        if (descriptors[0].revents & POLLIN)
+        {
+            int client = accept(listener, nullptr, nullptr);
+            if (client >= 0 && setNonBlocking(client))
+            {
+                clients.push_back(Client { client, {}, {} });
+            }
+            else if (client >= 0)
+            {
+                close(client);
+            }
+        }
+    }
+
+    notifications.stop();
+    for (const auto& client : clients)
+    {
+        close(client.socket);
+    }
+    if (wakePipe[0] >= 0)
+    {
+        close(wakePipe[0]);
+        close(wakePipe[1]);
+    }
+    close(listener);
+    unlink(socketPath);
+
+    api.AIO_shutdown();
+    shared->running.store(0, std::memory_order_release);
+    munmap(shared, sizeof(AIOBrokerSharedMemory));
+    shm_unlink(sharedMemoryName);
+    AIOApi::closeLibrary(handle);
+
+    return 0;
+}
@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+
+    AIOBrokerClient - use an AIO owned by the AIO broker
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "AIOBrokerProtocol.h"
+
+/*
+    AIOBrokerClient
+
+    Control getters (input gain, constant current, output limit, and module parameters other than the live
+    ones listed by AIOControlState::isLiveParameter) read the broker's shared memory: no system call and no
+    USB traffic. Everything else is forwarded to the broker as one request and returns the library's status.
+
+    The shared memory may be used without a socket connection; call attach only for a read-only client
+    such as a telemetry viewer. One client object should be used by one thread at a time.
+
+    Reads fail once the broker has exited. When a request finds the broker gone, the client disconnects, so
+    reads fail from then on instead of returning the state of a broker that has crashed. A client that is
+    only attached cannot tell that the broker crashed; it keeps reading the last state published.
+*/
+class AIOBrokerClient
+{
+public:
+    AIOBrokerClient() = default;
+
+    ~AIOBrokerClient()
+    {
+        disconnect();
+    }
+
+    AIOBrokerClient(const AIOBrokerClient&) = delete;
+    AIOBrokerClient& operator=(const AIOBrokerClient&) = delete;
+
+    /*
+        attach
+
+        Maps the broker's shared memory read-only
+
+        Returns true if successful
+    */
+    bool attach(const char* sharedMemoryName = AIOBrokerDefaultSharedMemoryName)
+    {
+        int descriptor = shm_open(sharedMemoryName, O_RDONLY, 0);
+        if (descriptor < 0)
+        {
+            return false;
+        }
+
+        void* memory = mmap(nullptr, sizeof(AIOBrokerSharedMemory), PROT_READ, MAP_SHARED, descriptor, 0);
+        close(descriptor);
+        if (MAP_FAILED == memory)
+        {
+            return false;
+        }
+
+        shared = static_cast<const AIOBrokerSharedMemory*>(memory);
+        if (AIOBrokerMagic != shared->magic || AIOBrokerVersion != shared->version)
+        {
+            munmap(const_cast<AIOBrokerSharedMemory*>(shared), sizeof(AIOBrokerSharedMemory));
+            shared = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    /*
+        connect
+
+        Attaches to the shared memory and opens the request socket
+
+        Returns true if successful
+    */
+    bool connect(const char* socketPath = AIOBrokerDefaultSocketPath, const char* sharedMemoryName = AIOBrokerDefaultSharedMemoryName)
+    {
+        disconnect();
+        if (false == attach(sharedMemoryName))
+        {
+            return false;
+        }
+
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+        socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (socket < 0 || ::connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+        {
+            disconnect();
+            return false;
+        }
+
+#ifdef SO_NOSIGPIPE
+        int noSignal = 1;
+        setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+        return true;
+    }
+
+    void disconnect()
+    {
+        if (socket >= 0)
+        {
+            close(socket);
+            socket = -1;
+        }
+        if (shared)
+        {
+            munmap(const_cast<AIOBrokerSharedMemory*>(shared), sizeof(AIOBrokerSharedMemory));
+            shared = nullptr;
+        }
+    }
+
+    /*
+        readState
+
+        Copies the control state most recently published by the broker without a system call
+
+        Returns false if not attached, if the broker has exited, or if every one of maxReadAttempts copies
+        overlapped a write
+    */
+    bool readState(AIOControlState& state) const
+    {
+        if (nullptr == shared || 0 == shared->running.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        for (int attempt = 0; attempt < maxReadAttempts; ++attempt)
+        {
+            uint32_t copy = shared->current.load(std::memory_order_acquire) & 1;
+            if (shared->state[copy].tryRead(state))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+        call
+
+        Sends one request to the broker. text and textBufferBytes receive any text result.
+
+        Returns the library's return value, or ECHO_AIO_NOT_INITIALIZED if the broker cannot be reached
+    */
+    int call(AIOBrokerRequest request, AIOBrokerResponse& response, char* const text = nullptr, size_t textBufferBytes = 0)
+    {
+        request.bufferBytes = static_cast<uint32_t>(std::min<size_t>(textBufferBytes, AIOBrokerMaxTextBytes));
+        std::memset(&response, 0, sizeof(response));
+        if (socket < 0)
+        {
+            return ECHO_AIO_NOT_INITIALIZED;
+        }
+        if (false == AIOBrokerWriteAll(socket, &request, sizeof(request)) ||
+            false == AIOBrokerReadAll(socket, &response, sizeof(response)))
+        {
+            disconnect();
+            return ECHO_AIO_NOT_INITIALIZED;
+        }
+
+        if (response.textBytes)
+        {
+            if (response.textBytes > request.bufferBytes || false == AIOBrokerReadAll(socket, text, response.textBytes))
+            {
+                disconnect();
+                return ECHO_AIO_USB_COMMAND_FAILED;
+            }
+        }
+        return response.status;
+    }
+
+    //
+    // Control getters served from shared memory
+    //
+    int getInputGain(int inputChannel, int* const gain) const
+    {
+        AIOControlState state;
+        int status = readInputChannel(inputChannel, state);
+        if (ECHO_AIO_OK == status)
+        {
+            *gain = state.inputGain[inputChannel];
+        }
+        return status;
+    }
+
+    int getConstantCurrentState(int inputChannel, int* const enabled) const
+    {
+        AIOControlState state;
+        int status = readInputChannel(inputChannel, state);
+        if (ECHO_AIO_OK == status)
+        {
+            *enabled = state.constantCurrent[inputChannel];
+        }
+        return status;
+    }
+
+    int getOutputLimitVolts(int outputChannel, double* const limitVolts) const
+    {
+        AIOControlState state;
+        if (false == readState(state))
+        {
+            return ECHO_AIO_NOT_INITIALIZED;
+        }
+        if (outputChannel < 0 || outputChannel >= state.numOutputChannels)
+        {
+            return ECHO_AIO_INVALID_OUTPUT_CHANNEL;
+        }
+        *limitVolts = state.outputLimitVolts[outputChannel];
+        return ECHO_AIO_OK;
+    }
+
+    int getModuleIntParameter(int moduleSlot, int parameter, int* const value)
+    {
+        if (AIOControlState::isLiveParameter(parameter) || AIOControlState::isDoubleParameter(parameter))
+        {
+            AIOBrokerResponse response;
+            int status = call(makeRequest(AIOFunction_AIO_getModuleIntParameter, moduleSlot, parameter), response);
+            *value = response.intValue;
+            return status;
+        }
+
+        AIOControlState state;
+        int status = readModule(moduleSlot, parameter, state);
+        if (ECHO_AIO_OK == status)
+        {
+            *value = state.modules[moduleSlot].intParameters[AIOControlState::getParameterIndex(parameter)];
+        }
+        return status;
+    }
+
+    int getModuleDoubleParameter(int moduleSlot, int parameter, double* const value)
+    {
+        if (AIOControlState::isLiveParameter(parameter) || false == AIOControlState::isDoubleParameter(parameter))
+        {
+            AIOBrokerResponse response;
+            int status = call(makeRequest(AIOFunction_AIO_getModuleDoubleParameter, moduleSlot, parameter), response);
+            *value = response.doubleValue;
+            return status;
+        }
+
+        AIOControlState state;
+        int status = readModule(moduleSlot, parameter, state);
+        if (ECHO_AIO_OK == status)
+        {
+            *value = state.modules[moduleSlot].doubleParameters[AIOControlState::getParameterIndex(parameter)];
+        }
+        return status;
+    }
+
+    //
+    // Calls forwarded to the broker
+    //
+    int isAIOConnected()
+    {
+        AIOBrokerResponse response;
+        return call(makeRequest(AIOFunction_AIO_isAIOConnected), response);
+    }
+
+    int setInputGain(int inputChannel, int gain)
+    {
+        AIOBrokerResponse response;
+        return call(makeRequest(AIOFunction_AIO_setInputGain, inputChannel, 0, gain), response);
+    }
+
+    int setConstantCurrentState(int inputChannel, int enabled)
+    {
+        AIOBrokerResponse response;
+        return call(makeRequest(AIOFunction_AIO_setConstantCurrentState, inputChannel, 0, enabled), response);
+    }
+
+    int setOutputLimitVolts(int outputChannel, double limitVolts)
+    {
+        AIOBrokerResponse response;
+        return call(makeRequest(AIOFunction_AIO_setOutputLimitVolts, outputChannel, 0, 0, limitVolts), response);
+    }
+
+    int setModuleIntParameter(int moduleSlot, int parameter, int value)
+    {
+        AIOBrokerResponse response;
+        return call(makeRequest(AIOFunction_AIO_setModuleIntParameter, moduleSlot, parameter, value), response);
+    }
+
+    int setModuleDoubleParameter(int moduleSlot, int parameter, double value)
+    {
+        AIOBrokerResponse response;
+        return call(makeRequest(AIOFunction_AIO_setModuleDoubleParameter, moduleSlot, parameter, 0, value), response);
+    }
+
+    int updateTDM(int moduleSlot)
+    {
+        AIOBrokerResponse response;
+        return call(makeRequest(AIOFunction_AIO_updateTDM, moduleSlot), response);
+    }
+
+    int getTEDSProperties(int inputChannel, char* const jsonText, size_t jsonBufferBytes, size_t* jsonBytesRequired)
+    {
+        AIOBrokerResponse response;
+        int status = call(makeRequest(AIOFunction_AIO_getTEDSProperties, inputChannel), response, jsonText, jsonText ? jsonBufferBytes : 0);
+        if (jsonBytesRequired)
+        {
+            *jsonBytesRequired = static_cast<size_t>(response.bytesRequired);
+        }
+        if (ECHO_AIO_OK == status && jsonText && response.bytesRequired > jsonBufferBytes)
+        {
+            return ECHO_AIO_BUFFER_TOO_SMALL;
+        }
+        return status;
+    }
+
+    static AIOBrokerRequest makeRequest(int function, int channel = 0, int parameter = 0, int intValue = 0, double doubleValue = 0.0)
+    {
+        AIOBrokerRequest request {};
+        request.function = function;
+        request.channel = channel;
+        request.parameter = parameter;
+        request.intValue = intValue;
+        request.doubleValue = doubleValue;
+        return request;
+    }
+
+private:
+    //
+    // Each copy fails only if the broker finished two writes while it was being made
+    //
+    static constexpr int maxReadAttempts = 64;
+
+    int readInputChannel(int inputChannel, AIOControlState& state) const
+    {
+        if (false == readState(state))
+        {
+            return ECHO_AIO_NOT_INITIALIZED;
+        }
+        if (inputChannel < 0 || inputChannel >= state.numInputChannels)
+        {
+            return ECHO_AIO_INVALID_INPUT_CHANNEL;
+        }
+        return ECHO_AIO_OK;
+    }
+
+    int readModule(int moduleSlot, int parameter, AIOControlState& state) const
+    {
+        if (false == readState(state))
+        {
+            return ECHO_AIO_NOT_INITIALIZED;
+        }
+        if (moduleSlot < 0 || moduleSlot >= AIO_numModuleSlots)
+        {
+            return ECHO_AIO_INVALID_MODULE_SLOT;
+        }
+
+        int type = state.modules[moduleSlot].type;
+        if (AIO_MODULE_NONE == type)
+        {
+            return ECHO_AIO_NOT_FOUND;
+        }
+        if (parameter < AIOControlState::getFirstParameter(type) || parameter > AIOControlState::getLastParameter(type))
+        {
+            return ECHO_AIO_INVALID_PARAMETER;
+        }
+        return ECHO_AIO_OK;
+    }
+
+    int socket = -1;
+    const AIOBrokerSharedMemory* shared = nullptr;
+};
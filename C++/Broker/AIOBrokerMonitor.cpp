@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    AIOBrokerMonitor - read-only telemetry viewer for the AIO broker
+
+    Prints the control state published by the broker. It only maps the shared
+    memory, so it makes no system calls per read and adds no USB traffic.
+
+    Usage: AIOBrokerMonitor [shared memory name] [interval ms] [count]
+
+  ==============================================================================
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include "AIOBrokerClient.h"
+
+int main(int argc, const char* argv[])
+{
+    const char* sharedMemoryName = argc > 1 ? argv[1] : AIOBrokerDefaultSharedMemoryName;
+    int intervalMilliseconds = argc > 2 ? std::atoi(argv[2]) : 500;
+    int count = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    AIOBrokerClient client;
+    if (false == client.attach(sharedMemoryName))
+    {
+        std::cout << "Unable to attach to AIO broker shared memory " << sharedMemoryName << std::endl;
+        return 1;
+    }
+
+    for (int line = 0; 0 == count || line < count; ++line)
+    {
+        AIOControlState state {};
+        if (false == client.readState(state))
+        {
+            std::cout << "AIO broker stopped" << std::endl;
+            return 1;
+        }
+
+        std::cout << "update " << state.updateCount << (state.connected ? "  connected" : "  not connected") << "  gain";
+        for (int channel = 0; channel < state.numInputChannels; ++channel)
+        {
+            std::cout << " " << state.inputGain[channel];
+        }
+        std::cout << "  CCP";
+        for (int channel = 0; channel < state.numInputChannels; ++channel)
+        {
+            std::cout << " " << state.constantCurrent[channel];
+        }
+        std::cout << "  limit";
+        for (int channel = 0; channel < state.numOutputChannels; ++channel)
+        {
+            std::cout << " " << state.outputLimitVolts[channel];
+        }
+        std::cout << std::endl;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMilliseconds));
+    }
+
+    return 0;
+}
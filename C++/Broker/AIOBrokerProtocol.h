@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    AIOBrokerProtocol - messages and shared memory layout for the AIO broker
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../Common/AIOControlState.h"
+
+static const char* const AIOBrokerDefaultSocketPath = "/tmp/echo-aio-broker.sock";
+static const char* const AIOBrokerDefaultSharedMemoryName = "/echo-aio-broker";
+
+constexpr uint32_t AIOBrokerMagic = 0x424f4941;     // "AIOB"
+constexpr uint32_t AIOBrokerVersion = 2;
+constexpr uint32_t AIOBrokerMaxTextBytes = 65536;
+
+#ifdef MSG_NOSIGNAL
+constexpr int AIOBrokerSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int AIOBrokerSendFlags = 0;       // macOS: AIOBrokerClient sets SO_NOSIGPIPE on its socket instead
+#endif
+
+/*
+    AIOBrokerSharedMemory
+
+    The broker's shared memory segment. The broker is the only writer; any number of processes may map it
+    read-only and read the state with AIOSeqlock::tryRead, without a system call.
+
+    As in AIOStateSnapshot, there are two copies of the state: the broker writes the copy readers are not using,
+    then switches current to it. A broker that dies in the middle of a write therefore leaves the other copy
+    readable. The broker clears running when it exits; a broker that crashes cannot, but its clients' socket
+    calls then fail.
+*/
+struct AIOBrokerSharedMemory
+{
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> running;      // cleared when the broker exits
+    std::atomic<uint32_t> current;      // copy readers use
+    AIOSeqlock<AIOControlState> state[2];
+};
+
+/*
+    AIOBrokerRequest
+    AIOBrokerResponse
+
+    One request per library call, sent over the broker's Unix domain socket. function is an AIOFunction value;
+    the other fields carry that function's arguments in declaration order:
+        channel         input channel, output channel, or module slot
+        parameter       module parameter number
+        intValue        integer argument (gain, enabled, parameter value)
+        doubleValue     double argument (limit volts, parameter value)
+        bufferBytes     size of the caller's text buffer (AIO_getTEDSProperties, AIO_getErrorString,
+                        AIO_getLibraryVersion)
+
+    The response carries the return value in status, an integer or double result, and, for text results,
+    bytesRequired plus textBytes of text immediately after the response.
+*/
+struct AIOBrokerRequest
+{
+    int32_t function;
+    int32_t channel;
+    int32_t parameter;
+    int32_t intValue;
+    double doubleValue;
+    uint32_t bufferBytes;
+    uint32_t reserved;
+};
+
+struct AIOBrokerResponse
+{
+    int32_t status;
+    int32_t intValue;
+    double doubleValue;
+    uint64_t bytesRequired;
+    uint32_t textBytes;
+    uint32_t reserved;
+};
+
+/*
+    Socket helpers
+
+    Blocking transfers for clients; the broker's own sockets are non-blocking. Writing to a broker that has
+    exited fails instead of raising SIGPIPE. Return true once every byte has been transferred
+*/
+inline bool AIOBrokerWriteAll(int socket, const void* data, size_t bytes)
+{
+    auto bytePointer = static_cast<const char*>(data);
+    while (bytes)
+    {
+        ssize_t written = ::send(socket, bytePointer, bytes, AIOBrokerSendFlags);
+        if (written < 0 && EINTR == errno)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        bytePointer += written;
+        bytes -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+inline bool AIOBrokerReadAll(int socket, void* data, size_t bytes)
+{
+    auto bytePointer = static_cast<char*>(data);
+    while (bytes)
+    {
+        ssize_t count = ::read(socket, bytePointer, bytes);
+        if (count < 0 && EINTR == errno)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return false;
+        }
+        bytePointer += count;
+        bytes -= static_cast<size_t>(count);
+    }
+    return true;
+}
@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    AIOApi - resolve-once dispatch table for the EchoAIOInterface library
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#if _WIN32
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "../../EchoAIOInterface.h"
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * Export list
+ *
+ * Every function exported by EchoAIOInterface.h, in header order. Each entry expands X(name) where name is both
+ * the exported symbol and the AIOApi member that holds its address.
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+#if _WIN32
+#define AIO_API_WINDOWS_FUNCTIONS(X) \
+    X(AIO_getASIOPreferredBufferSize) \
+    X(AIO_setASIOPreferredBufferSize) \
+    X(AIO_getSampleRate) \
+    X(AIO_setSampleRate)
+#else
+#define AIO_API_WINDOWS_FUNCTIONS(X)
+#endif
+
+#define AIO_API_FUNCTIONS(X) \
+    X(AIO_initialize) \
+    X(AIO_shutdown) \
+    X(AIO_getLibraryVersion) \
+    X(AIO_isAIOConnected) \
+    X(AIO_getNumInputChannels) \
+    X(AIO_getNumOutputChannels) \
+    X(AIO_hasComboModule) \
+    X(AIO_hasTModule) \
+    X(AIO_getErrorString) \
+    X(AIO_hasInputGainControl) \
+    X(AIO_getInputGain) \
+    X(AIO_setInputGain) \
+    X(AIO_hasConstantCurrentControl) \
+    X(AIO_getConstantCurrentState) \
+    X(AIO_setConstantCurrentState) \
+    X(AIO_hasTEDS) \
+    X(AIO_getTEDSProperties) \
+    X(AIO_hasOutputGainControl) \
+    X(AIO_getOutputGain) \
+    X(AIO_setOutputGain) \
+    X(AIO_hasOutputLimitControl) \
+    X(AIO_getOutputLimitVolts) \
+    X(AIO_setOutputLimitVolts) \
+    AIO_API_WINDOWS_FUNCTIONS(X) \
+    X(AIO_getModuleIntParameter) \
+    X(AIO_setModuleIntParameter) \
+    X(AIO_getModuleDoubleParameter) \
+    X(AIO_setModuleDoubleParameter) \
+    X(AIO_updateTDM)
+
+/*
+    AIOFunction
+
+    One identifier per export, in AIO_API_FUNCTIONS order (e.g. AIOFunction_AIO_getInputGain); useful for
+    per-function bookkeeping and for naming calls in messages and logs.
+*/
+enum AIOFunction
+{
+#define AIO_API_DECLARE_FUNCTION_ID(name) AIOFunction_##name,
+    AIO_API_FUNCTIONS(AIO_API_DECLARE_FUNCTION_ID)
+#undef AIO_API_DECLARE_FUNCTION_ID
+    AIOFunction_count
+};
+
+inline const char* getAIOFunctionName(int function)
+{
+    static const char* const names[] =
+    {
+#define AIO_API_DECLARE_FUNCTION_NAME(name) #name,
+        AIO_API_FUNCTIONS(AIO_API_DECLARE_FUNCTION_NAME)
+#undef AIO_API_DECLARE_FUNCTION_NAME
+    };
+
+    return function >= 0 && function < AIOFunction_count ? names[function] : "unknown";
+}
+
+
+#if _WIN32
+using AIOLibraryHandle = HMODULE;
+#else
+using AIOLibraryHandle = void*;
+#endif
+
+/*
+    AIOApi
+
+    Holds one typed function pointer for every library export. Call resolve once after loading the library;
+    after that, each call through the table (e.g. api.AIO_getInputGain(0, &gain)) costs a single indirect call
+    with no symbol lookup and no cast.
+
+    The table is plain data; copy it freely, but keep the library loaded for as long as any copy is in use.
+*/
+struct AIOApi
+{
+#define AIO_API_DECLARE_POINTER(name) decltype(&::name) name = nullptr;
+    AIO_API_FUNCTIONS(AIO_API_DECLARE_POINTER)
+#undef AIO_API_DECLARE_POINTER
+
+    std::string libraryVersion;
+
+    /*
+        resolve
+
+        Parameters
+            handle      Library handle returned by openLibrary
+            error       Receives a description of the first problem found
+
+        Looks up every export, then reads AIO_getLibraryVersion. Stops at the first missing symbol.
+
+        Returns true if every export was found and the library reported a version string
+    */
+    bool resolve(AIOLibraryHandle handle, std::string& error)
+    {
+        *this = AIOApi {};
+
+#define AIO_API_RESOLVE_POINTER(name) \
+        name = reinterpret_cast<decltype(name)>(findSymbol(handle, #name)); \
+        if (nullptr == name) \
+        { \
+            error = "Unable to find " #name " function"; \
+            return false; \
+        }
+        AIO_API_FUNCTIONS(AIO_API_RESOLVE_POINTER)
+#undef AIO_API_RESOLVE_POINTER
+
+        char text[256] = {};
+        AIO_getLibraryVersion(text, sizeof(text));
+        if (0 == text[0])
+        {
+            error = "Unable to read library version";
+            return false;
+        }
+
+        libraryVersion = text;
+        return true;
+    }
+
+    /*
+        Platform library helpers
+
+        defaultLibraryName is the library file name for the current platform; openLibrary returns nullptr if
+        the library could not be loaded.
+
+        openLibraryInstance loads a private copy of the library with its own global state. On Linux any number
+        of instances may share one path. On macOS and Windows the loader shares a module between every load of
+        the same file and returns the same handle, so pass a separate copy of the library file for each
+        instance. A private copy does not choose a unit: its AIO_initialize opens whichever AIO it finds first
+        (see AIODeviceList).
+    */
+#if _WIN32
+    static constexpr const char* defaultLibraryName = "EchoAIOInterface.dll";
+
+    static AIOLibraryHandle openLibrary(const char* path)
+    {
+        return LoadLibraryA(path);
+    }
+
+    static AIOLibraryHandle openLibraryInstance(const char* path)
+    {
+        return LoadLibraryA(path);
+    }
+
+    static void closeLibrary(AIOLibraryHandle handle)
+    {
+        FreeLibrary(handle);
+    }
+
+    static void* findSymbol(AIOLibraryHandle handle, const char* name)
+    {
+        return reinterpret_cast<void*>(GetProcAddress(handle, name));
+    }
+#else
+#if __APPLE__
+    static constexpr const char* defaultLibraryName = "EchoAIOInterface.dylib";
+#else
+    static constexpr const char* defaultLibraryName = "EchoAIOInterface.so";
+#endif
+
+    static AIOLibraryHandle openLibrary(const char* path)
+    {
+        return dlopen(path, RTLD_LOCAL | RTLD_NOW);
+    }
+
+    static AIOLibraryHandle openLibraryInstance(const char* path)
+    {
+#if __linux__
+        return dlmopen(LM_ID_NEWLM, path, RTLD_LOCAL | RTLD_NOW);
+#else
+        return dlopen(path, RTLD_LOCAL | RTLD_NOW);
+#endif
+    }
+
+    static void closeLibrary(AIOLibraryHandle handle)
+    {
+        dlclose(handle);
+    }
+
+    static void* findSymbol(AIOLibraryHandle handle, const char* name)
+    {
+        return dlsym(handle, name);
+    }
+#endif
+};
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    AIOAsyncInitializer - run AIO_initialize on a background thread
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include "AIOApi.h"
+
+/*
+    AIOAsyncInitializer
+
+    AIO_initialize blocks until USB enumeration and module discovery finish. initializeAsync starts it on a
+    background thread and returns at once, so the caller can continue with its own startup work.
+
+    Before calling any other library function, call waitUntilInitialized:
+        AIO_WAIT    blocks only until discovery completes, then returns ECHO_AIO_OK
+        AIO_TRY     returns ECHO_AIO_NOT_INITIALIZED immediately if discovery is still running
+
+    Destroying the initializer waits for discovery to finish; it does not call AIO_shutdown.
+*/
+class AIOAsyncInitializer
+{
+public:
+    using Callback = void (*)(void* context);
+
+    enum WaitMode
+    {
+        AIO_WAIT,
+        AIO_TRY
+    };
+
+    explicit AIOAsyncInitializer(const AIOApi& api_) :
+        api(api_)
+    {
+    }
+
+    ~AIOAsyncInitializer()
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    AIOAsyncInitializer(const AIOAsyncInitializer&) = delete;
+    AIOAsyncInitializer& operator=(const AIOAsyncInitializer&) = delete;
+
+    /*
+        initializeAsync
+
+        Parameters
+            callback        Optional function called on the background thread once discovery completes
+            context         Passed unchanged to callback
+
+        Only the first call starts discovery. A later call returns the same future and does not call its
+        callback.
+
+        Returns a future that becomes ready once discovery completes
+    */
+    std::shared_future<void> initializeAsync(Callback callback = nullptr, void* context = nullptr)
+    {
+        if (ready.valid())
+        {
+            return ready;
+        }
+
+        std::promise<void> promise;
+        ready = promise.get_future().share();
+
+        thread = std::thread([this, callback, context, promise = std::move(promise)]() mutable
+            {
+                api.AIO_initialize();
+                promise.set_value();
+                if (callback)
+                {
+                    callback(context);
+                }
+            });
+
+        return ready;
+    }
+
+    /*
+        isInitialized
+
+        Returns true once discovery has completed
+    */
+    bool isInitialized() const
+    {
+        return ready.valid() && std::future_status::ready == ready.wait_for(std::chrono::seconds(0));
+    }
+
+    /*
+        waitUntilInitialized
+
+        Returns ECHO_AIO_OK once discovery has completed, or ECHO_AIO_NOT_INITIALIZED if initializeAsync
+        was never called or if mode is AIO_TRY and discovery is still running
+    */
+    int waitUntilInitialized(WaitMode mode = AIO_WAIT) const
+    {
+        if (false == ready.valid())
+        {
+            return ECHO_AIO_NOT_INITIALIZED;
+        }
+
+        if (AIO_TRY == mode)
+        {
+            return isInitialized() ? ECHO_AIO_OK : ECHO_AIO_NOT_INITIALIZED;
+        }
+
+        ready.wait();
+        return ECHO_AIO_OK;
+    }
+
+private:
+    const AIOApi& api;
+    std::thread thread;
+    std::shared_future<void> ready;
+};
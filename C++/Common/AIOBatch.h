@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    AIOBatch - queue control changes and send them together
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include "AIOApi.h"
+#include "AIOControlCache.h"
+
+/*
+    AIOBatch
+
+    Collects setter calls between beginBatch and commitBatch, then sends them in one pass, in the order they
+    were made. Before anything is sent the queue is coalesced: a call is merged into an earlier call to the same
+    control only if no other call to the same input channel, output channel, or module slot was made between
+    them. Dependent settings therefore reach each channel and slot in exactly the order the caller made them;
+    for example, VARIABLE_DC_POWER_ENABLE = 0, TARGET_MILLIVOLTS = 5000, VARIABLE_DC_POWER_ENABLE = 1 is sent as
+    three calls, while a run of gain changes to one channel with nothing else in between is sent as one.
+
+    The library has no multi-command transfer, so each remaining change is still its own USB command; the
+    saving comes from the changes that coalescing removes. Pass an AIOControlCache to keep it up to date.
+
+    Setters called while no batch is open are sent at once. One batch object belongs to one thread.
+*/
+class AIOBatch
+{
+public:
+    explicit AIOBatch(const AIOApi& api_, AIOControlCache* cache_ = nullptr) :
+        api(api_),
+        cache(cache_)
+    {
+    }
+
+    AIOBatch(const AIOBatch&) = delete;
+    AIOBatch& operator=(const AIOBatch&) = delete;
+
+    /*
+        beginBatch
+
+        Starts queueing setter calls; any calls already queued are discarded
+    */
+    void beginBatch()
+    {
+        items.clear();
+        open = true;
+    }
+
+    bool isBatchOpen() const
+    {
+        return open;
+    }
+
+    /*
+        commitBatch
+
+        Parameters
+            itemStatus      Receives one return value per queued call, in the order the calls were made; a call
+                            merged into a later call to the same control gets that call's return value
+
+        Sends the queued calls and closes the batch. Every call is attempted, even after one fails.
+
+        Returns 0 if every call succeeded, otherwise the return value of the first call that failed
+    */
+    int commitBatch(std::vector<int>& itemStatus)
+    {
+        open = false;
+
+        //
+        // Coalesce: a call merges into the latest send to its channel or slot, if that send is to the same control
+        //
+        std::vector<size_t> sendIndex(items.size());
+        std::vector<Item> sends;
+        for (size_t index = 0; index < items.size(); ++index)
+        {
+            size_t send = sends.size();
+            while (send > 0 && sends[send - 1].getTarget() != items[index].getTarget())
+            {
+                --send;
+            }
+            if (send > 0 && sends[send - 1].isSameControl(items[index]))
+            {
+                sends[send - 1].intValue = items[index].intValue;
+                sends[send - 1].doubleValue = items[index].doubleValue;
+                sendIndex[index] = send - 1;
+            }
+            else
+            {
+                sendIndex[index] = sends.size();
+                sends.push_back(items[index]);
+            }
+        }
+
+        std::vector<int> sendStatus(sends.size());
+        for (size_t send = 0; send < sends.size(); ++send)
+        {
+            sendStatus[send] = execute(sends[send]);
+        }
+
+        int result = ECHO_AIO_OK;
+        itemStatus.resize(items.size());
+        for (size_t index = 0; index < items.size(); ++index)
+        {
+            itemStatus[index] = sendStatus[sendIndex[index]];
+            if (ECHO_AIO_OK == result)
+            {
+                result = itemStatus[index];
+            }
+        }
+
+        lastSendCount = sends.size();
+        items.clear();
+        return result;
+    }
+
+    /*
+        getLastSendCount
+
+        Returns the number of calls the last commitBatch sent to the library after coalescing
+    */
+    size_t getLastSendCount() const
+    {
+        return lastSendCount;
+    }
+
+    //
+    // Setters; same parameters as the library functions. While a batch is open each returns 0 once the call
+    // is queued; the result of the call itself comes from commitBatch.
+    //
+    int setInputGain(int inputChannel, int gain)
+    {
+        return add(Item { AIOFunction_AIO_setInputGain, inputChannel, 0, gain, 0.0 });
+    }
+
+    int setConstantCurrentState(int inputChannel, int enabled)
+    {
+        return add(Item { AIOFunction_AIO_setConstantCurrentState, inputChannel, 0, enabled, 0.0 });
+    }
+
+    int setOutputGain(int outputChannel, int gain)
+    {
+        return add(Item { AIOFunction_AIO_setOutputGain, outputChannel, 0, gain, 0.0 });
+    }
+
+    int setOutputLimitVolts(int outputChannel, double limitVolts)
+    {
+        return add(Item { AIOFunction_AIO_setOutputLimitVolts, outputChannel, 0, 0, limitVolts });
+    }
+
+    int setModuleIntParameter(int moduleSlot, int parameter, int value)
+    {
+        return add(Item { AIOFunction_AIO_setModuleIntParameter, moduleSlot, parameter, value, 0.0 });
+    }
+
+    int setModuleDoubleParameter(int moduleSlot, int parameter, double value)
+    {
+        return add(Item { AIOFunction_AIO_setModuleDoubleParameter, moduleSlot, parameter, 0, value });
+    }
+
+private:
+    struct Item
+    {
+        int function;       // AIOFunction
+        int channel;        // channel or module slot
+        int parameter;
+        int intValue;
+        double doubleValue;
+
+        bool isSameControl(const Item& other) const
+        {
+            return function == other.function && channel == other.channel && parameter == other.parameter;
+        }
+
+        //
+        // Input channel, output channel, or module slot, each numbered apart
+        //
+        int getTarget() const
+        {
+            switch (function)
+            {
+            case AIOFunction_AIO_setInputGain:
+            case AIOFunction_AIO_setConstantCurrentState:
+                return channel;
+
+            case AIOFunction_AIO_setOutputGain:
+            case AIOFunction_AIO_setOutputLimitVolts:
+                return 0x10000 + channel;
+            }
+            return 0x20000 + channel;
+        }
+    };
+
+    int add(const Item& item)
+    {
+        if (false == open)
+        {
+            return execute(item);
+        }
+
+        items.push_back(item);
+        return ECHO_AIO_OK;
+    }
+
+    int execute(const Item& item)
+    {
+        switch (item.function)
+        {
+        case AIOFunction_AIO_setInputGain:
+            return cache ? cache->setInputGain(item.channel, item.intValue) : api.AIO_setInputGain(item.channel, item.intValue);
+
+        case AIOFunction_AIO_setConstantCurrentState:
+            return cache ? cache->setConstantCurrentState(item.channel, item.intValue) : api.AIO_setConstantCurrentState(item.channel, item.intValue);
+
+        case AIOFunction_AIO_setOutputGain:
+            return cache ? cache->setOutputGain(item.channel, item.intValue) : api.AIO_setOutputGain(item.channel, item.intValue);
+
+        case AIOFunction_AIO_setOutputLimitVolts:
+            return cache ? cache->setOutputLimitVolts(item.channel, item.doubleValue) : api.AIO_setOutputLimitVolts(item.channel, item.doubleValue);
+
+        case AIOFunction_AIO_setModuleIntParameter:
+            return cache ? cache->setModuleIntParameter(item.channel, item.parameter, item.intValue) :
+                api.AIO_setModuleIntParameter(item.channel, item.parameter, item.intValue);
+
+        case AIOFunction_AIO_setModuleDoubleParameter:
+            return cache ? cache->setModuleDoubleParameter(item.channel, item.parameter, item.doubleValue) :
+                api.AIO_setModuleDoubleParameter(item.channel, item.parameter, item.doubleValue);
+        }
+        return ECHO_AIO_NOT_SUPPORTED;
+    }
+
+    const AIOApi& api;
+    AIOControlCache* cache;
+    std::vector<Item> items;
+    size_t lastSendCount = 0;
+    bool open = false;
+};
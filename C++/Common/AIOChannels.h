@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    AIOChannels - read and write a control on many channels in one call
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AIOApi.h"
+#include "AIOControlCache.h"
+
+/*
+    AIOChannels
+
+    Array forms of the per-channel library functions. Getters fill channels 0 to count - 1 of a caller-provided
+    array; setters take parallel arrays of channel numbers and values. Nothing is allocated.
+
+    Each function takes either a resolved AIOApi table or an AIOControlCache; through a cache, every value it
+    already holds is returned from memory and only the rest are read from the device. The library has no
+    multi-channel command, so through the table each channel is still its own USB command.
+
+    Every channel is attempted, even after one fails; a getter leaves a failed channel's array entry unchanged.
+    Functions that return a status return 0 if every channel succeeded, otherwise the return value of the
+    first channel that failed.
+*/
+struct AIOChannels
+{
+    //
+    // Input channels
+    //
+    template <typename Target>
+    static int getInputGains(Target& target, int* const gains, int count)
+    {
+        return forEach(count, [&](int index) { return getInputGain(target, index, &gains[index]); });
+    }
+
+    template <typename Target>
+    static int setInputGains(Target& target, const int* channels, const int* gains, int count)
+    {
+        return forEach(count, [&](int index) { return setInputGain(target, channels[index], gains[index]); });
+    }
+
+    template <typename Target>
+    static int getConstantCurrentStates(Target& target, int* const enabled, int count)
+    {
+        return forEach(count, [&](int index) { return getConstantCurrentState(target, index, &enabled[index]); });
+    }
+
+    template <typename Target>
+    static int setConstantCurrentStates(Target& target, const int* channels, const int* enabled, int count)
+    {
+        return forEach(count, [&](int index) { return setConstantCurrentState(target, channels[index], enabled[index]); });
+    }
+
+    static void hasInputGainControls(const AIOApi& api, int* const hasControl, int count)
+    {
+        for (int channel = 0; channel < count; ++channel)
+        {
+            hasControl[channel] = api.AIO_hasInputGainControl(channel);
+        }
+    }
+
+    static void hasConstantCurrentControls(const AIOApi& api, int* const hasControl, int count)
+    {
+        for (int channel = 0; channel < count; ++channel)
+        {
+            hasControl[channel] = api.AIO_hasConstantCurrentControl(channel);
+        }
+    }
+
+    static void hasTEDS(const AIOApi& api, int* const hasTEDS, int count)
+    {
+        for (int channel = 0; channel < count; ++channel)
+        {
+            hasTEDS[channel] = api.AIO_hasTEDS(channel);
+        }
+    }
+
+    //
+    // Output channels
+    //
+    template <typename Target>
+    static int getOutputGains(Target& target, int* const gains, int count)
+    {
+        return forEach(count, [&](int index) { return getOutputGain(target, index, &gains[index]); });
+    }
+
+    template <typename Target>
+    static int setOutputGains(Target& target, const int* channels, const int* gains, int count)
+    {
+        return forEach(count, [&](int index) { return setOutputGain(target, channels[index], gains[index]); });
+    }
+
+    template <typename Target>
+    static int getAllOutputLimitVolts(Target& target, double* const limitVolts, int count)
+    {
+        return forEach(count, [&](int index) { return getOutputLimitVolts(target, index, &limitVolts[index]); });
+    }
+
+    template <typename Target>
+    static int setAllOutputLimitVolts(Target& target, const int* channels, const double* limitVolts, int count)
+    {
+        return forEach(count, [&](int index) { return setOutputLimitVolts(target, channels[index], limitVolts[index]); });
+    }
+
+    static void hasOutputGainControls(const AIOApi& api, int* const hasControl, int count)
+    {
+        for (int channel = 0; channel < count; ++channel)
+        {
+            hasControl[channel] = api.AIO_hasOutputGainControl(channel);
+        }
+    }
+
+    static void hasOutputLimitControls(const AIOApi& api, int* const hasControl, int count)
+    {
+        for (int channel = 0; channel < count; ++channel)
+        {
+            hasControl[channel] = api.AIO_hasOutputLimitControl(channel);
+        }
+    }
+
+private:
+    template <typename Call>
+    static int forEach(int count, Call call)
+    {
+        int result = ECHO_AIO_OK;
+        for (int index = 0; index < count; ++index)
+        {
+            int status = call(index);
+            if (ECHO_AIO_OK == result)
+            {
+                result = status;
+            }
+        }
+        return result;
+    }
+
+    //
+    // The same call made through the library table or through a cache
+    //
+    static int getInputGain(const AIOApi& api, int channel, int* const value) { return api.AIO_getInputGain(channel, value); }
+    static int getInputGain(AIOControlCache& cache, int channel, int* const value) { return cache.getInputGain(channel, value); }
+    static int setInputGain(const AIOApi& api, int channel, int value) { return api.AIO_setInputGain(channel, value); }
+    static int setInputGain(AIOControlCache& cache, int channel, int value) { return cache.setInputGain(channel, value); }
+
+    static int getConstantCurrentState(const AIOApi& api, int channel, int* const value) { return api.AIO_getConstantCurrentState(channel, value); }
+    static int getConstantCurrentState(AIOControlCache& cache, int channel, int* const value) { return cache.getConstantCurrentState(channel, value); }
+    static int setConstantCurrentState(const AIOApi& api, int channel, int value) { return api.AIO_setConstantCurrentState(channel, value); }
+    static int setConstantCurrentState(AIOControlCache& cache, int channel, int value) { return cache.setConstantCurrentState(channel, value); }
+
+    static int getOutputGain(const AIOApi& api, int channel, int* const value) { return api.AIO_getOutputGain(channel, value); }
+    static int getOutputGain(AIOControlCache& cache, int channel, int* const value) { return cache.getOutputGain(channel, value); }
+    static int setOutputGain(const AIOApi& api, int channel, int value) { return api.AIO_setOutputGain(channel, value); }
+    static int setOutputGain(AIOControlCache& cache, int channel, int value) { return cache.setOutputGain(channel, value); }
+
+    static int getOutputLimitVolts(const AIOApi& api, int channel, double* const value) { return api.AIO_getOutputLimitVolts(channel, value); }
+    static int getOutputLimitVolts(AIOControlCache& cache, int channel, double* const value) { return cache.getOutputLimitVolts(channel, value); }
+    static int setOutputLimitVolts(const AIOApi& api, int channel, double value) { return api.AIO_setOutputLimitVolts(channel, value); }
+    static int setOutputLimitVolts(AIOControlCache& cache, int channel, double value) { return cache.setOutputLimitVolts(channel, value); }
+};
@@ -0,0 +1,482 @@
+/*
+  ==============================================================================
+
+    AIOCommandQueue - asynchronous library calls with several commands in
+    flight
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AIOApi.h"
+
+struct AIOCommandResult
+{
+    int status = ECHO_AIO_OK;
+    int intValue = 0;               // value read by an int getter
+    double doubleValue = 0.0;       // value read by a double getter
+    std::string text;               // JSON text read by getTEDSPropertiesAsync
+};
+
+/*
+    AIOCommandQueue
+
+    The *Async functions queue a library call and return at once. Up to maxInFlight calls run at the same time
+    on the queue's worker threads, so one control thread can keep several USB commands in flight. Each call's
+    callback runs, and its future becomes ready, as soon as that call completes, so a slow or stuck call holds
+    up only the calls queued after it on the same target.
+
+    Apart from safety commands, calls to the same input channel, output channel, or module slot (the call's
+    target) never overlap and reach the device in the order they were queued, so a set followed by a get of the
+    same control reads the new value. Calls to different channels and slots overlap freely; this relies on the
+    library accepting calls from several threads at once. Use maxInFlight = 1 for a library that does not.
+
+    Callbacks run on the worker thread that made the call. Callbacks for one target run one at a time, in the
+    order the calls were queued; callbacks for different targets may run at the same time. A callback must not
+    wait for the future of a later call to its own target.
+
+    Safety commands (see isSafetyCommand: turning off a module's DC supplies, reading the over current
+    condition) have a lane of their own. A dedicated worker runs them ahead of every queued call to other
+    channels and slots, so a backlog of TEDS reads or module settings cannot hold them up. On their own module
+    slot they wait only for earlier writes of the supply and over current parameters (VARIABLE_DC_POWER_ENABLE,
+    5VDC_ENABLE, VARIABLE_DC_POWER_TARGET_MILLIVOLTS, OVER_CURRENT_THRESHOLD, and OVER_CURRENT_CONDITION), so
+    a queued enable never overtakes a later disable and a read of the condition after clearing it returns the
+    cleared value. They overlap any other call on that slot. Later calls to the slot still wait for them. Pass
+    AIO_NO_SAFETY_LANE to treat them like any other call; the safety worker is then not started, which keeps
+    at most maxInFlight calls in the library.
+*/
+class AIOCommandQueue
+{
+public:
+    using Callback = void (*)(const AIOCommandResult& result, void* context);
+
+    enum SafetyMode
+    {
+        AIO_SAFETY_LANE,
+        AIO_NO_SAFETY_LANE
+    };
+
+    explicit AIOCommandQueue(const AIOApi& api_, int maxInFlight = 4, SafetyMode safetyMode_ = AIO_SAFETY_LANE) :
+        api(api_),
+        safetyMode(safetyMode_)
+    {
+        for (int index = 0; index < std::max(maxInFlight, 1); ++index)
+        {
+            workers.emplace_back(&AIOCommandQueue::run, this, false);
+        }
+        if (AIO_SAFETY_LANE == safetyMode)
+        {
+            workers.emplace_back(&AIOCommandQueue::run, this, true);
+        }
+    }
+
+    /*
+        ~AIOCommandQueue
+
+        Completes every queued call, then stops the worker threads
+    */
+    ~AIOCommandQueue()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        safetyWake.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    AIOCommandQueue(const AIOCommandQueue&) = delete;
+    AIOCommandQueue& operator=(const AIOCommandQueue&) = delete;
+
+    /*
+        waitUntilIdle
+
+        Blocks until every queued call has completed and its callback has returned
+    */
+    void waitUntilIdle()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [this]() { return isIdle(); });
+    }
+
+    /*
+        isSafetyCommand
+
+        Returns true for the calls that run in the safety lane: setting AIO-C VARIABLE_DC_POWER_ENABLE or
+        5VDC_ENABLE to 0, and reading OVER_CURRENT_CONDITION
+    */
+    static bool isSafetyCommand(int function, int parameter, int intValue)
+    {
+        switch (function)
+        {
+        case AIOFunction_AIO_setModuleIntParameter:
+            return 0 == intValue && (AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE == parameter ||
+                AIO_COMBO_MODULE_PARAMETER_5VDC_ENABLE == parameter);
+
+        case AIOFunction_AIO_getModuleIntParameter:
+            return AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION == parameter;
+        }
+        return false;
+    }
+
+    //
+    // Input channels
+    //
+    std::future<AIOCommandResult> getInputGainAsync(int inputChannel, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_getInputGain, inputChannel, 0, 0, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> setInputGainAsync(int inputChannel, int gain, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_setInputGain, inputChannel, 0, gain, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> getConstantCurrentStateAsync(int inputChannel, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_getConstantCurrentState, inputChannel, 0, 0, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> setConstantCurrentStateAsync(int inputChannel, int enabled, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_setConstantCurrentState, inputChannel, 0, enabled, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> getTEDSPropertiesAsync(int inputChannel, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_getTEDSProperties, inputChannel, 0, 0, 0.0, callback, context);
+    }
+
+    //
+    // Output channels
+    //
+    std::future<AIOCommandResult> getOutputGainAsync(int outputChannel, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_getOutputGain, outputChannel, 0, 0, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> setOutputGainAsync(int outputChannel, int gain, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_setOutputGain, outputChannel, 0, gain, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> getOutputLimitVoltsAsync(int outputChannel, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_getOutputLimitVolts, outputChannel, 0, 0, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> setOutputLimitVoltsAsync(int outputChannel, double limitVolts, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_setOutputLimitVolts, outputChannel, 0, 0, limitVolts, callback, context);
+    }
+
+    //
+    // Module parameters
+    //
+    std::future<AIOCommandResult> getModuleIntParameterAsync(int moduleSlot, int parameter, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_getModuleIntParameter, moduleSlot, parameter, 0, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> setModuleIntParameterAsync(int moduleSlot, int parameter, int value, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_setModuleIntParameter, moduleSlot, parameter, value, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> getModuleDoubleParameterAsync(int moduleSlot, int parameter, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_getModuleDoubleParameter, moduleSlot, parameter, 0, 0.0, callback, context);
+    }
+
+    std::future<AIOCommandResult> setModuleDoubleParameterAsync(int moduleSlot, int parameter, double value, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_setModuleDoubleParameter, moduleSlot, parameter, 0, value, callback, context);
+    }
+
+    std::future<AIOCommandResult> updateTDMAsync(int moduleSlot, Callback callback = nullptr, void* context = nullptr)
+    {
+        return add(AIOFunction_AIO_updateTDM, moduleSlot, 0, 0, 0.0, callback, context);
+    }
+
+private:
+    enum State
+    {
+        queued,
+        running
+    };
+
+    struct Command
+    {
+        int function;
+        int channel;            // channel or module slot
+        int parameter;
+        int intValue;
+        double doubleValue;
+        Callback callback;
+        void* context;
+        std::promise<AIOCommandResult> promise;
+        AIOCommandResult result;
+        State state = queued;
+        bool safety = false;
+    };
+
+    //
+    // Calls with the same target must not overlap: one target per input channel, output channel, and module slot
+    //
+    static int getTarget(const Command& command)
+    {
+        switch (command.function)
+        {
+        case AIOFunction_AIO_getOutputGain:
+        case AIOFunction_AIO_setOutputGain:
+        case AIOFunction_AIO_getOutputLimitVolts:
+        case AIOFunction_AIO_setOutputLimitVolts:
+            return 0x10000 + command.channel;
+
+        case AIOFunction_AIO_getModuleIntParameter:
+        case AIOFunction_AIO_setModuleIntParameter:
+        case AIOFunction_AIO_getModuleDoubleParameter:
+        case AIOFunction_AIO_setModuleDoubleParameter:
+        case AIOFunction_AIO_updateTDM:
+            return 0x20000 + command.channel;
+        }
+        return command.channel;
+    }
+
+    std::future<AIOCommandResult> add(int function, int channel, int parameter, int intValue, double doubleValue,
+        Callback callback, void* context)
+    {
+        std::unique_ptr<Command> command(new Command { function, channel, parameter, intValue, doubleValue, callback, context, {}, {} });
+        command->safety = AIO_SAFETY_LANE == safetyMode && isSafetyCommand(function, parameter, intValue);
+        bool safety = command->safety;
+        auto future = command->promise.get_future();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            commands.push_back(std::move(command));
+        }
+
+        //
+        // The safety worker waits apart, so a call is never handed to a worker that cannot take it
+        //
+        if (safety)
+        {
+            safetyWake.notify_one();
+        }
+        wake.notify_one();
+        return future;
+    }
+
+    //
+    // Writes a safety command must stay behind on its slot: the supplies and the over current settings
+    //
+    static bool isSafetyStateWrite(const Command& command)
+    {
+        if (AIOFunction_AIO_setModuleIntParameter != command.function &&
+            AIOFunction_AIO_setModuleDoubleParameter != command.function)
+        {
+            return false;
+        }
+        return AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE == command.parameter ||
+            AIO_COMBO_MODULE_PARAMETER_5VDC_ENABLE == command.parameter ||
+            AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_TARGET_MILLIVOLTS == command.parameter ||
+            AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD == command.parameter ||
+            AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION == command.parameter;
+    }
+
+    //
+    // Returns the oldest queued safety command with no earlier supply or over current write to its slot still queued, running, or
+    // in its callback; otherwise the oldest queued command whose target has no earlier command in any of those
+    // states. The safety worker only takes safety commands.
+    //
+    Command* findRunnable(bool safetyWorker)
+    {
+        Command* runnable = nullptr;
+        std::vector<int> busy;
+        std::vector<int> safetyStateBusy;
+        for (auto& command : commands)
+        {
+            int target = getTarget(*command);
+            if (queued == command->state)
+            {
+                if (command->safety)
+                {
+                    if (safetyStateBusy.end() == std::find(safetyStateBusy.begin(), safetyStateBusy.end(), target))
+                    {
+                        return command.get();
+                    }
+                }
+                else if (nullptr == runnable && false == safetyWorker && busy.end() == std::find(busy.begin(), busy.end(), target))
+                {
+                    runnable = command.get();
+                }
+            }
+            busy.push_back(target);
+            if (isSafetyStateWrite(*command))
+            {
+                safetyStateBusy.push_back(target);
+            }
+        }
+        return runnable;
+    }
+
+    bool isIdle() const
+    {
+        return commands.empty();
+    }
+
+    void deliver(Command& command)
+    {
+        if (command.callback)
+        {
+            command.callback(command.result, command.context);
+        }
+        command.promise.set_value(std::move(command.result));
+    }
+
+    void run(bool safetyWorker)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;)
+        {
+            Command* command = findRunnable(safetyWorker);
+            if (nullptr == command)
+            {
+                if (stopping && commands.empty())
+                {
+                    return;
+                }
+                (safetyWorker ? safetyWake : wake).wait(guard);
+                continue;
+            }
+
+            //
+            // The command stays in the queue until its callback returns, which keeps its target busy and the
+            // callbacks for that target in order
+            //
+            command->state = running;
+            guard.unlock();
+            execute(*command);
+            deliver(*command);
+            guard.lock();
+
+            commands.erase(std::find_if(commands.begin(), commands.end(),
+                [command](const std::unique_ptr<Command>& entry) { return entry.get() == command; }));
+
+            if (isIdle())
+            {
+                idle.notify_all();
+            }
+
+            //
+            // Finishing a command may make a later command on the same target runnable
+            //
+            wake.notify_all();
+            safetyWake.notify_all();
+        }
+    }
+
+    void execute(Command& command)
+    {
+        AIOCommandResult& result = command.result;
+        switch (command.function)
+        {
+        case AIOFunction_AIO_getInputGain:
+            result.status = api.AIO_getInputGain(command.channel, &result.intValue);
+            break;
+
+        case AIOFunction_AIO_setInputGain:
+            result.status = api.AIO_setInputGain(command.channel, command.intValue);
+            break;
+
+        case AIOFunction_AIO_getConstantCurrentState:
+            result.status = api.AIO_getConstantCurrentState(command.channel, &result.intValue);
+            break;
+
+        case AIOFunction_AIO_setConstantCurrentState:
+            result.status = api.AIO_setConstantCurrentState(command.channel, command.intValue);
+            break;
+
+        case AIOFunction_AIO_getTEDSProperties:
+        {
+            size_t bytesRequired = 0;
+            result.status = api.AIO_getTEDSProperties(command.channel, nullptr, 0, &bytesRequired);
+            if (ECHO_AIO_OK == result.status && bytesRequired)
+            {
+                std::vector<char> json(bytesRequired);
+                result.status = api.AIO_getTEDSProperties(command.channel, json.data(), json.size(), &bytesRequired);
+                if (ECHO_AIO_OK == result.status)
+                {
+                    result.text = json.data();
+                }
+            }
+            break;
+        }
+
+        case AIOFunction_AIO_getOutputGain:
+            result.status = api.AIO_getOutputGain(command.channel, &result.intValue);
+            break;
+
+        case AIOFunction_AIO_setOutputGain:
+            result.status = api.AIO_setOutputGain(command.channel, command.intValue);
+            break;
+
+        case AIOFunction_AIO_getOutputLimitVolts:
+            result.status = api.AIO_getOutputLimitVolts(command.channel, &result.doubleValue);
+            break;
+
+        case AIOFunction_AIO_setOutputLimitVolts:
+            result.status = api.AIO_setOutputLimitVolts(command.channel, command.doubleValue);
+            break;
+
+        case AIOFunction_AIO_getModuleIntParameter:
+            result.status = api.AIO_getModuleIntParameter(command.channel, command.parameter, &result.intValue);
+            break;
+
+        case AIOFunction_AIO_setModuleIntParameter:
+            result.status = api.AIO_setModuleIntParameter(command.channel, command.parameter, command.intValue);
+            break;
+
+        case AIOFunction_AIO_getModuleDoubleParameter:
+            result.status = api.AIO_getModuleDoubleParameter(command.channel, command.parameter, &result.doubleValue);
+            break;
+
+        case AIOFunction_AIO_setModuleDoubleParameter:
+            result.status = api.AIO_setModuleDoubleParameter(command.channel, command.parameter, command.doubleValue);
+            break;
+
+        case AIOFunction_AIO_updateTDM:
+            result.status = api.AIO_updateTDM(command.channel);
+            break;
+
+        default:
+            result.status = ECHO_AIO_NOT_SUPPORTED;
+            break;
+        }
+    }
+
+    const AIOApi& api;
+    SafetyMode safetyMode;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable safetyWake;
+    std::condition_variable idle;
+    std::deque<std::unique_ptr<Command>> commands;     // queued, running, or in the callback
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
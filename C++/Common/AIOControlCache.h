@@ -0,0 +1,357 @@
+/*
+  ==============================================================================
+
+    AIOControlCache - write-through shadow copy of the AIO controls
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "AIOApi.h"
+#include "AIOControlState.h"
+#include "AIONotification.h"
+
+/*
+    AIOControlCache
+
+    Serves control getters from memory. The first read of a control goes to the device; after that the stored
+    value is returned until the control is set through this cache (the new value is stored once the set
+    succeeds) or the cache is invalidated. startListening invalidates the cache each time the library
+    broadcasts AIO_notificationString (on Windows and macOS), so changes made by other clients are picked up.
+    Where there is no broadcast, setMaximumAge makes stored values expire.
+
+    Parameters the hardware changes on its own (AIOControlState::isLiveParameter: AUX IN, measured voltage and
+    current, over current condition) always go to the device, as do calls with an out-of-range channel or slot.
+    A failed set forgets the stored value, since the write may still have reached the device, and sets to one
+    control that overlap each other are not stored either, since their order on the device is unknown.
+
+    A set that would write the value the cache already holds for that control is skipped (elided) and returns
+    0 without a USB command, unless AIO_WRITE_ALWAYS is passed. Elision only happens while startListening is
+    in effect or a maximum age is set; otherwise a control changed by another client could never be written
+    back, and every set goes to the device.
+
+    One cache may be shared by any number of threads.
+*/
+class AIOControlCache
+{
+public:
+    enum WriteMode
+    {
+        AIO_WRITE_IF_CHANGED,
+        AIO_WRITE_ALWAYS
+    };
+
+    explicit AIOControlCache(const AIOApi& api_) :
+        api(api_)
+    {
+    }
+
+    ~AIOControlCache()
+    {
+        stopListening();
+    }
+
+    AIOControlCache(const AIOControlCache&) = delete;
+    AIOControlCache& operator=(const AIOControlCache&) = delete;
+
+    /*
+        startListening
+
+        Invalidates the cache on each AIO_notificationString broadcast
+
+        Returns false where the platform has no broadcast; use setMaximumAge there
+    */
+    bool startListening()
+    {
+        bool started = listener.start(&AIOControlCache::onNotification, this);
+        listening.store(started, std::memory_order_relaxed);
+        return started;
+    }
+
+    void stopListening()
+    {
+        listening.store(false, std::memory_order_relaxed);
+        listener.stop();
+    }
+
+    /*
+        invalidate
+
+        Forgets every stored value; the next read of each control goes to the device
+    */
+    void invalidate()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ++generation;
+    }
+
+    static void onNotification(void* context)
+    {
+        static_cast<AIOControlCache*>(context)->invalidate();
+    }
+
+    /*
+        setMaximumAge
+
+        Parameters
+            milliseconds    Stored values older than this are read again from the device; 0 (the default)
+                            keeps them until invalidate is called
+    */
+    void setMaximumAge(int milliseconds)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        maximumAge = std::chrono::milliseconds(milliseconds);
+    }
+
+    /*
+        getElidedWriteCount
+
+        Returns the number of sets skipped because the control already held the value
+    */
+    uint64_t getElidedWriteCount() const
+    {
+        return elidedWrites.load(std::memory_order_relaxed);
+    }
+
+    void resetElidedWriteCount()
+    {
+        elidedWrites.store(0, std::memory_order_relaxed);
+    }
+
+    //
+    // Channel controls; same parameters and return values as the library functions
+    //
+    int getInputGain(int inputChannel, int* const gain)
+    {
+        return get(isChannel(inputChannel) ? &inputGain[inputChannel] : nullptr, gain,
+            [&](int* value) { return api.AIO_getInputGain(inputChannel, value); });
+    }
+
+    int setInputGain(int inputChannel, int gain, WriteMode mode = AIO_WRITE_IF_CHANGED)
+    {
+        return set(isChannel(inputChannel) ? &inputGain[inputChannel] : nullptr, gain, mode,
+            [&]() { return api.AIO_setInputGain(inputChannel, gain); });
+    }
+
+    int getConstantCurrentState(int inputChannel, int* const enabled)
+    {
+        return get(isChannel(inputChannel) ? &constantCurrent[inputChannel] : nullptr, enabled,
+            [&](int* value) { return api.AIO_getConstantCurrentState(inputChannel, value); });
+    }
+
+    int setConstantCurrentState(int inputChannel, int enabled, WriteMode mode = AIO_WRITE_IF_CHANGED)
+    {
+        return set(isChannel(inputChannel) ? &constantCurrent[inputChannel] : nullptr, enabled, mode,
+            [&]() { return api.AIO_setConstantCurrentState(inputChannel, enabled); });
+    }
+
+    int getOutputGain(int outputChannel, int* const gain)
+    {
+        return get(isChannel(outputChannel) ? &outputGain[outputChannel] : nullptr, gain,
+            [&](int* value) { return api.AIO_getOutputGain(outputChannel, value); });
+    }
+
+    int setOutputGain(int outputChannel, int gain, WriteMode mode = AIO_WRITE_IF_CHANGED)
+    {
+        return set(isChannel(outputChannel) ? &outputGain[outputChannel] : nullptr, gain, mode,
+            [&]() { return api.AIO_setOutputGain(outputChannel, gain); });
+    }
+
+    int getOutputLimitVolts(int outputChannel, double* const limitVolts)
+    {
+        return get(isChannel(outputChannel) ? &outputLimitVolts[outputChannel] : nullptr, limitVolts,
+            [&](double* value) { return api.AIO_getOutputLimitVolts(outputChannel, value); });
+    }
+
+    int setOutputLimitVolts(int outputChannel, double limitVolts, WriteMode mode = AIO_WRITE_IF_CHANGED)
+    {
+        return set(isChannel(outputChannel) ? &outputLimitVolts[outputChannel] : nullptr, limitVolts, mode,
+            [&]() { return api.AIO_setOutputLimitVolts(outputChannel, limitVolts); });
+    }
+
+    //
+    // Module parameters
+    //
+    int getModuleIntParameter(int moduleSlot, int parameter, int* const value)
+    {
+        return get(findParameter(moduleIntParameters, moduleSlot, parameter), value,
+            [&](int* result) { return api.AIO_getModuleIntParameter(moduleSlot, parameter, result); });
+    }
+
+    int setModuleIntParameter(int moduleSlot, int parameter, int value, WriteMode mode = AIO_WRITE_IF_CHANGED)
+    {
+        return set(findParameter(moduleIntParameters, moduleSlot, parameter), value, mode,
+            [&]() { return api.AIO_setModuleIntParameter(moduleSlot, parameter, value); });
+    }
+
+    int getModuleDoubleParameter(int moduleSlot, int parameter, double* const value)
+    {
+        return get(findParameter(moduleDoubleParameters, moduleSlot, parameter), value,
+            [&](double* result) { return api.AIO_getModuleDoubleParameter(moduleSlot, parameter, result); });
+    }
+
+    int setModuleDoubleParameter(int moduleSlot, int parameter, double value, WriteMode mode = AIO_WRITE_IF_CHANGED)
+    {
+        return set(findParameter(moduleDoubleParameters, moduleSlot, parameter), value, mode,
+            [&]() { return api.AIO_setModuleDoubleParameter(moduleSlot, parameter, value); });
+    }
+
+private:
+    template <typename T>
+    struct Entry
+    {
+        T value {};
+        uint64_t generation = 0;        // valid while equal to the cache generation
+        uint64_t writes = 0;            // sets started; a read that overlaps a set is not stored
+        int writesInFlight = 0;
+        bool overlapped = false;        // two sets were in flight at once since writesInFlight was last 0
+        std::chrono::steady_clock::time_point time;
+    };
+
+    enum
+    {
+        parametersPerSlot = AIO_MAX_MODULE_PARAMETERS * 2   // AIO-C parameters, then AIO-T parameters
+    };
+
+    static bool isChannel(int channel)
+    {
+        return channel >= 0 && channel < AIO_MAX_CHANNELS;
+    }
+
+    template <typename T>
+    static Entry<T>* findParameter(Entry<T> (&entries)[AIO_numModuleSlots][parametersPerSlot], int moduleSlot, int parameter)
+    {
+        int index = AIOControlState::getParameterIndex(parameter);
+        if (moduleSlot < 0 || moduleSlot >= AIO_numModuleSlots || index < 0 || AIOControlState::isLiveParameter(parameter))
+        {
+            return nullptr;
+        }
+        if (parameter >= AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION && parameter <= AIO_T_MODULE_PARAMETER_FSYNC_WIDTH)
+        {
+            index += AIO_MAX_MODULE_PARAMETERS;
+        }
+        return &entries[moduleSlot][index];
+    }
+
+    template <typename T>
+    bool isFresh(const Entry<T>& entry) const
+    {
+        return entry.generation == generation &&
+            (0 == maximumAge.count() || std::chrono::steady_clock::now() - entry.time < maximumAge);
+    }
+
+    template <typename T, typename Read>
+    int get(Entry<T>* entry, T* const value, Read read)
+    {
+        if (nullptr == entry || nullptr == value)
+        {
+            return read(value);
+        }
+
+        uint64_t readGeneration = 0;
+        uint64_t readWrites = 0;
+        bool storable = false;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (isFresh(*entry))
+            {
+                *value = entry->value;
+                return ECHO_AIO_OK;
+            }
+            readGeneration = generation;
+            readWrites = entry->writes;
+            storable = 0 == entry->writesInFlight;
+        }
+
+        //
+        // Read the device without holding the lock; the result is only stored if nothing invalidated the
+        // cache or set this control while the read was in flight
+        //
+        T result {};
+        int status = read(&result);
+        if (ECHO_AIO_OK == status)
+        {
+            *value = result;
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (storable && readGeneration == generation && readWrites == entry->writes)
+            {
+                store(*entry, result);
+            }
+        }
+        return status;
+    }
+
+    template <typename T, typename Write>
+    int set(Entry<T>* entry, T value, WriteMode mode, Write write)
+    {
+        if (nullptr == entry)
+        {
+            return write();
+        }
+
+        uint64_t writeGeneration = 0;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            bool canElide = listening.load(std::memory_order_relaxed) || maximumAge.count();
+            if (AIO_WRITE_IF_CHANGED == mode && canElide && isFresh(*entry) && entry->value == value)
+            {
+                elidedWrites.fetch_add(1, std::memory_order_relaxed);
+                return ECHO_AIO_OK;
+            }
+            writeGeneration = generation;
+            ++entry->writes;
+            if (entry->writesInFlight++)
+            {
+                entry->overlapped = true;
+            }
+        }
+
+        int status = write();
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (ECHO_AIO_OK == status && false == entry->overlapped && writeGeneration == generation)
+        {
+            store(*entry, value);
+        }
+        else
+        {
+            entry->generation = 0;
+        }
+        if (0 == --entry->writesInFlight)
+        {
+            entry->overlapped = false;
+        }
+        return status;
+    }
+
+    template <typename T>
+    void store(Entry<T>& entry, T value)
+    {
+        entry.value = value;
+        entry.generation = generation;
+        entry.time = std::chrono::steady_clock::now();
+    }
+
+    const AIOApi& api;
+    std::mutex lock;
+    uint64_t generation = 1;
+    std::chrono::steady_clock::duration maximumAge {};
+    std::atomic<uint64_t> elidedWrites { 0 };
+    std::atomic<bool> listening { false };
+    AIONotificationListener listener;
+
+    Entry<int> inputGain[AIO_MAX_CHANNELS];
+    Entry<int> constantCurrent[AIO_MAX_CHANNELS];
+    Entry<int> outputGain[AIO_MAX_CHANNELS];
+    Entry<double> outputLimitVolts[AIO_MAX_CHANNELS];
+    Entry<int> moduleIntParameters[AIO_numModuleSlots][parametersPerSlot];
+    Entry<double> moduleDoubleParameters[AIO_numModuleSlots][parametersPerSlot];
+};
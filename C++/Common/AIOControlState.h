@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    AIOControlState - plain-data copy of every AIO control, plus a seqlock
+    for publishing it to readers that must not block
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "AIOApi.h"
+#include "AIOTopology.h"
+
+enum
+{
+    AIO_MAX_CHANNELS = 32,
+    AIO_MAX_MODULE_PARAMETERS = 16
+};
+
+struct AIOModuleState
+{
+    int32_t type;                                           // AIOModuleType
+    int32_t intParameters[AIO_MAX_MODULE_PARAMETERS];       // indexed by AIOControlState::getParameterIndex
+    double doubleParameters[AIO_MAX_MODULE_PARAMETERS];
+};
+
+/*
+    AIOControlState
+
+    Fixed-size, pointer-free snapshot of the AIO controls, safe to place in shared memory. Channel arrays hold
+    numInputChannels and numOutputChannels valid entries; module parameters are indexed by their offset from
+    the first parameter of the module type (e.g. AIO_COMBO_MODULE_PARAMETER_AUX_OUT - 0xc0000).
+*/
+struct AIOControlState
+{
+    int32_t connected;
+    int32_t numInputChannels;
+    int32_t numOutputChannels;
+    int32_t inputGain[AIO_MAX_CHANNELS];
+    int32_t constantCurrent[AIO_MAX_CHANNELS];
+    double outputLimitVolts[AIO_MAX_CHANNELS];
+    AIOModuleState modules[AIO_numModuleSlots];
+    uint64_t updateCount;
+
+    /*
+        getParameterIndex
+
+        Returns the array index for an AIO-C or AIO-T module parameter, or -1 if the parameter is unknown
+    */
+    static int getParameterIndex(int parameter)
+    {
+        if (parameter >= AIO_COMBO_MODULE_PARAMETER_FIRMWARE_VERSION && parameter <= AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION)
+        {
+            return parameter - AIO_COMBO_MODULE_PARAMETER_FIRMWARE_VERSION;
+        }
+        if (parameter >= AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION && parameter <= AIO_T_MODULE_PARAMETER_FSYNC_WIDTH)
+        {
+            return parameter - AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION;
+        }
+        return -1;
+    }
+
+    static bool isDoubleParameter(int parameter)
+    {
+        return AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT == parameter ||
+            AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD == parameter;
+    }
+
+    /*
+        isLiveParameter
+
+        Returns true for parameters the hardware changes on its own (AUX IN pins, measured voltage and current,
+        over current condition); a stored copy of these is only as fresh as its last refresh
+    */
+    static bool isLiveParameter(int parameter)
+    {
+        switch (parameter)
+        {
+        case AIO_COMBO_MODULE_PARAMETER_AUX_IN:
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_MILLIVOLTS:
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT:
+        case AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION:
+            return true;
+        }
+        return false;
+    }
+
+    static int getFirstParameter(int moduleType)
+    {
+        if (AIO_MODULE_COMBO == moduleType)
+        {
+            return AIO_COMBO_MODULE_PARAMETER_FIRMWARE_VERSION;
+        }
+        return AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION;
+    }
+
+    static int getLastParameter(int moduleType)
+    {
+        if (AIO_MODULE_COMBO == moduleType)
+        {
+            return AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION;
+        }
+        return AIO_T_MODULE_PARAMETER_FSYNC_WIDTH;
+    }
+
+    /*
+        query
+
+        Reads every channel control and module parameter from the device
+    */
+    static AIOControlState query(const AIOApi& api)
+    {
+        AIOControlState state;
+        std::memset(&state, 0, sizeof(state));
+
+        state.connected = api.AIO_isAIOConnected();
+        state.numInputChannels = std::min<int32_t>(api.AIO_getNumInputChannels(), AIO_MAX_CHANNELS);
+        state.numOutputChannels = std::min<int32_t>(api.AIO_getNumOutputChannels(), AIO_MAX_CHANNELS);
+
+        for (int channel = 0; channel < state.numInputChannels; ++channel)
+        {
+            api.AIO_getInputGain(channel, &state.inputGain[channel]);
+            api.AIO_getConstantCurrentState(channel, &state.constantCurrent[channel]);
+        }
+
+        for (int channel = 0; channel < state.numOutputChannels; ++channel)
+        {
+            api.AIO_getOutputLimitVolts(channel, &state.outputLimitVolts[channel]);
+        }
+
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            queryModule(api, slot, state.modules[slot]);
+        }
+
+        return state;
+    }
+
+    static void queryModule(const AIOApi& api, int slot, AIOModuleState& module)
+    {
+        std::memset(&module, 0, sizeof(module));
+        module.type = api.AIO_hasComboModule(slot) ? AIO_MODULE_COMBO : api.AIO_hasTModule(slot) ? AIO_MODULE_T : AIO_MODULE_NONE;
+        if (AIO_MODULE_NONE == module.type)
+        {
+            return;
+        }
+
+        for (int parameter = getFirstParameter(module.type); parameter <= getLastParameter(module.type); ++parameter)
+        {
+            int index = getParameterIndex(parameter);
+            if (isDoubleParameter(parameter))
+            {
+                api.AIO_getModuleDoubleParameter(slot, parameter, &module.doubleParameters[index]);
+            }
+            else
+            {
+                api.AIO_getModuleIntParameter(slot, parameter, &module.intParameters[index]);
+            }
+        }
+    }
+};
+
+/*
+    AIOSeqlock
+
+    Publishes a trivially copyable value from one writer thread to any number of readers. Readers never lock,
+    allocate, or make a system call; they retry only if a write overlapped their copy. The object has no
+    pointers, so it may live in memory shared between processes.
+*/
+template <typename T>
+struct AIOSeqlock
+{
+    std::atomic<uint32_t> sequence { 0 };
+    T value;
+
+    /*
+        write
+
+        Single writer only
+    */
+    void write(const T& newValue)
+    {
+        uint32_t start = sequence.load(std::memory_order_relaxed);
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&value, &newValue, sizeof(T));
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    /*
+        tryRead
+
+        Returns false if a write was in progress; result is then unchanged
+    */
+    bool tryRead(T& result) const
+    {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            return false;
+        }
+
+        T copy;
+        std::memcpy(&copy, &value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != before)
+        {
+            return false;
+        }
+
+        result = copy;
+        return true;
+    }
+
+    void read(T& result) const
+    {
+        while (false == tryRead(result))
+        {
+        }
+    }
+};
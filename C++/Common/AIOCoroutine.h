@@ -0,0 +1,474 @@
+/*
+  ==============================================================================
+
+    AIOCoroutine - C++20 coroutine front end for the AIO library
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include "AIOCommandQueue.h"
+
+template <typename T>
+class AIOTask;
+
+/*
+    AIOExecutor
+
+    Runs coroutines on the one thread that calls run. Library calls complete on AIOCommandQueue worker
+    threads, which post the waiting coroutine back here, so a coroutine only ever runs on the run thread and
+    needs no locking of its own.
+*/
+class AIOExecutor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    AIOExecutor() = default;
+    AIOExecutor(const AIOExecutor&) = delete;
+    AIOExecutor& operator=(const AIOExecutor&) = delete;
+
+    /*
+        spawn
+
+        Parameters
+            task            Coroutine to run; it starts the next time run resumes coroutines
+
+        Call from the run thread, or from any thread while run is not running
+    */
+    inline void spawn(AIOTask<void>&& task);
+
+    /*
+        run
+
+        Resumes coroutines as their library calls complete and their sleeps expire
+
+        Returns when every spawned coroutine has finished
+    */
+    void run()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;)
+        {
+            auto now = Clock::now();
+            while (false == timers.empty() && timers.begin()->first <= now)
+            {
+                ready.push_back(timers.begin()->second);
+                timers.erase(timers.begin());
+            }
+
+            if (false == ready.empty())
+            {
+                std::coroutine_handle<> handle = ready.front();
+                ready.pop_front();
+                guard.unlock();
+                handle.resume();
+                guard.lock();
+                continue;
+            }
+
+            if (0 == running)
+            {
+                return;
+            }
+
+            if (timers.empty())
+            {
+                wake.wait(guard);
+            }
+            else
+            {
+                wake.wait_until(guard, timers.begin()->first);
+            }
+        }
+    }
+
+    /*
+        post
+
+        Queues a suspended coroutine to be resumed by run; may be called from any thread
+    */
+    void post(std::coroutine_handle<> handle)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ready.push_back(handle);
+        }
+        wake.notify_one();
+    }
+
+    /*
+        sleepFor
+
+        co_await executor.sleepFor(duration) suspends the calling coroutine without blocking the run thread
+    */
+    auto sleepFor(Clock::duration duration)
+    {
+        struct Sleep
+        {
+            AIOExecutor& executor;
+            Clock::time_point time;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                std::lock_guard<std::mutex> guard(executor.lock);
+                executor.timers.emplace(time, handle);
+            }
+            void await_resume() const noexcept {}
+        };
+        return Sleep { *this, Clock::now() + duration };
+    }
+
+private:
+    //
+    // Owns a spawned task; counts it as running until it returns
+    //
+    struct Detached
+    {
+        struct promise_type
+        {
+            Detached get_return_object() noexcept { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    static Detached detach(AIOExecutor& executor, AIOTask<void> task);
+
+    void finished()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        --running;
+    }
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::coroutine_handle<>> ready;
+    std::multimap<Clock::time_point, std::coroutine_handle<>> timers;
+    int running = 0;
+};
+
+//
+// Holds the co_return value of an AIOTask
+//
+template <typename T>
+struct AIOTaskResult
+{
+    std::optional<T> value;
+
+    void return_value(T result) { value = std::move(result); }
+    T take() { return std::move(*value); }
+};
+
+template <>
+struct AIOTaskResult<void>
+{
+    void return_void() noexcept {}
+    void take() noexcept {}
+};
+
+/*
+    AIOTask
+
+    Return type of a coroutine that co_awaits AIO operations. A task does nothing until it is awaited or passed
+    to AIOExecutor::spawn; co_await task runs it and gives back its co_return value.
+*/
+template <typename T = void>
+class AIOTask
+{
+public:
+    struct promise_type : AIOTaskResult<T>
+    {
+        std::coroutine_handle<> continuation;
+
+        AIOTask get_return_object() noexcept
+        {
+            return AIOTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        //
+        // Resume the awaiting coroutine directly, without going back through the executor
+        //
+        auto final_suspend() noexcept
+        {
+            struct Resume
+            {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    std::coroutine_handle<> continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+            return Resume {};
+        }
+
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    AIOTask(AIOTask&& other) noexcept :
+        handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    AIOTask(const AIOTask&) = delete;
+    AIOTask& operator=(const AIOTask&) = delete;
+    AIOTask& operator=(AIOTask&&) = delete;
+
+    ~AIOTask()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) noexcept
+    {
+        handle.promise().continuation = waiting;
+        return handle;
+    }
+
+    T await_resume()
+    {
+        return handle.promise().take();
+    }
+
+private:
+    explicit AIOTask(std::coroutine_handle<promise_type> handle_) :
+        handle(handle_)
+    {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+inline AIOExecutor::Detached AIOExecutor::detach(AIOExecutor& executor, AIOTask<void> task)
+{
+    co_await task;
+    executor.finished();
+}
+
+inline void AIOExecutor::spawn(AIOTask<void>&& task)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ++running;
+    }
+
+    //
+    // The detached coroutine starts suspended; its first resume happens on the run thread
+    //
+    post(detach(*this, std::move(task)).handle);
+}
+
+/*
+    AIOCoroutines
+
+    Awaitable forms of the library calls:
+
+        AIOCommandResult result = co_await aio.setInputGain(channel, 100);
+        AIOCommandResult teds = co_await aio.readTEDS(channel);             // JSON in teds.text
+        co_await aio.waitForAuxIn(slot, 0x03);
+
+    Each co_await queues the call on an AIOCommandQueue and suspends the coroutine; the run thread is free to
+    resume other coroutines until the call completes. Any number of coroutines can wait at once without a
+    thread each; how many calls reach the library at the same time is set by the queue's maxInFlight.
+    Calls to the same channel or slot reach the device in the order they were made.
+*/
+class AIOCoroutines
+{
+public:
+    AIOCoroutines(AIOExecutor& executor_, AIOCommandQueue& queue_) :
+        executor(executor_),
+        queue(queue_)
+    {
+    }
+
+    AIOCoroutines(const AIOCoroutines&) = delete;
+    AIOCoroutines& operator=(const AIOCoroutines&) = delete;
+
+    //
+    // Input channels
+    //
+    auto getInputGain(int inputChannel)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.getInputGainAsync(inputChannel, callback, context); });
+    }
+
+    auto setInputGain(int inputChannel, int gain)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.setInputGainAsync(inputChannel, gain, callback, context); });
+    }
+
+    auto getConstantCurrentState(int inputChannel)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.getConstantCurrentStateAsync(inputChannel, callback, context); });
+    }
+
+    auto setConstantCurrentState(int inputChannel, int enabled)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.setConstantCurrentStateAsync(inputChannel, enabled, callback, context); });
+    }
+
+    auto readTEDS(int inputChannel)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.getTEDSPropertiesAsync(inputChannel, callback, context); });
+    }
+
+    //
+    // Output channels
+    //
+    auto getOutputGain(int outputChannel)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.getOutputGainAsync(outputChannel, callback, context); });
+    }
+
+    auto setOutputGain(int outputChannel, int gain)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.setOutputGainAsync(outputChannel, gain, callback, context); });
+    }
+
+    auto getOutputLimitVolts(int outputChannel)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.getOutputLimitVoltsAsync(outputChannel, callback, context); });
+    }
+
+    auto setOutputLimitVolts(int outputChannel, double limitVolts)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.setOutputLimitVoltsAsync(outputChannel, limitVolts, callback, context); });
+    }
+
+    //
+    // Module parameters
+    //
+    auto getModuleIntParameter(int moduleSlot, int parameter)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.getModuleIntParameterAsync(moduleSlot, parameter, callback, context); });
+    }
+
+    auto setModuleIntParameter(int moduleSlot, int parameter, int value)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.setModuleIntParameterAsync(moduleSlot, parameter, value, callback, context); });
+    }
+
+    auto getModuleDoubleParameter(int moduleSlot, int parameter)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.getModuleDoubleParameterAsync(moduleSlot, parameter, callback, context); });
+    }
+
+    auto setModuleDoubleParameter(int moduleSlot, int parameter, double value)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.setModuleDoubleParameterAsync(moduleSlot, parameter, value, callback, context); });
+    }
+
+    auto updateTDM(int moduleSlot)
+    {
+        return operation([=](AIOCommandQueue& commands, AIOCommandQueue::Callback callback, void* context)
+            { return commands.updateTDMAsync(moduleSlot, callback, context); });
+    }
+
+    /*
+        waitForAuxIn
+
+        Parameters
+            moduleSlot      Slot of an AIO-C module
+            mask            AUX IN bits that must all be set
+            pollInterval    Time between reads of AUX IN; the run thread resumes other coroutines meanwhile
+
+        The library does not report AUX IN changes, so AUX IN is read until the bits are set
+
+        Returns, through co_await, the last AUX IN read; status is non-zero if a read failed
+    */
+    AIOTask<AIOCommandResult> waitForAuxIn(int moduleSlot, int mask,
+        AIOExecutor::Clock::duration pollInterval = std::chrono::milliseconds(1))
+    {
+        for (;;)
+        {
+            AIOCommandResult result = co_await getModuleIntParameter(moduleSlot, AIO_COMBO_MODULE_PARAMETER_AUX_IN);
+            if (ECHO_AIO_OK != result.status || mask == (result.intValue & mask))
+            {
+                co_return result;
+            }
+            co_await executor.sleepFor(pollInterval);
+        }
+    }
+
+private:
+    //
+    // Awaitable for one queued call; the queue's completion callback posts the coroutine back to the executor
+    //
+    template <typename Start>
+    struct Operation
+    {
+        AIOExecutor& executor;
+        AIOCommandQueue& queue;
+        Start start;
+        AIOCommandResult result;
+        std::coroutine_handle<> waiting;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            waiting = handle;
+            start(queue, &Operation::complete, this);
+        }
+
+        AIOCommandResult await_resume() { return std::move(result); }
+
+        static void complete(const AIOCommandResult& result, void* context)
+        {
+            auto operation = static_cast<Operation*>(context);
+            operation->result = result;
+            operation->executor.post(operation->waiting);
+        }
+    };
+
+    template <typename Start>
+    Operation<Start> operation(Start start)
+    {
+        return Operation<Start> { executor, queue, start, {}, {} };
+    }
+
+    AIOExecutor& executor;
+    AIOCommandQueue& queue;
+};
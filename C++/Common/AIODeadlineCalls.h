@@ -0,0 +1,387 @@
+/*
+  ==============================================================================
+
+    AIODeadlineCalls - library calls that give up after a deadline
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <vector>
+#include "AIOCommandQueue.h"
+
+/*
+    AIODeadlineCalls
+
+    The library's calls block until the USB command completes. These forms run each call on an AIOCommandQueue
+    worker thread and wait for it only until a deadline; if the call has not completed by then they return
+    ECHO_AIO_TIMEOUT and the calling thread carries on.
+
+    Every function takes an optional deadline in milliseconds: AIO_DEFAULT_DEADLINE (the default) uses the
+    value passed to the constructor or setDefaultDeadline, and AIO_NO_DEADLINE waits as long as the call takes.
+
+    The try forms never wait. The first try call starts the library call and returns ECHO_AIO_TIMEOUT unless it
+    has already completed; calling again with the same arguments returns ECHO_AIO_TIMEOUT until the result is
+    ready, then returns the result. A try call with different arguments for the same control starts a new call.
+
+    A library call cannot be cancelled: after a timeout it still runs to completion on its worker thread, and a
+    setter that timed out may still take effect. Each result is delivered as soon as its own call completes
+    (see AIOCommandQueue), so while one call is stuck only later calls to the same channel or slot wait behind
+    it; the stuck call does keep its worker busy until it returns. The destructor waits for calls that are
+    still running.
+
+    One object may be shared by any number of threads.
+*/
+class AIODeadlineCalls
+{
+public:
+    enum
+    {
+        AIO_DEFAULT_DEADLINE = -1,
+        AIO_NO_DEADLINE = 0
+    };
+
+    /*
+        AIODeadlineCalls
+
+        Parameters
+            api                     Library table the calls go to
+            deadlineMilliseconds    Default deadline; AIO_NO_DEADLINE for none
+            maxInFlight             Calls that may run at once (see AIOCommandQueue); a worker stuck on a call
+                                    is unavailable until that call completes
+    */
+    explicit AIODeadlineCalls(const AIOApi& api, int deadlineMilliseconds = 2000, int maxInFlight = 2) :
+        queue(api, maxInFlight),
+        defaultDeadline(deadlineMilliseconds)
+    {
+    }
+
+    AIODeadlineCalls(const AIODeadlineCalls&) = delete;
+    AIODeadlineCalls& operator=(const AIODeadlineCalls&) = delete;
+
+    void setDefaultDeadline(int milliseconds)
+    {
+        defaultDeadline.store(milliseconds, std::memory_order_relaxed);
+    }
+
+    int getDefaultDeadline() const
+    {
+        return defaultDeadline.load(std::memory_order_relaxed);
+    }
+
+    /*
+        getTimeoutCount
+
+        Returns the number of calls that returned ECHO_AIO_TIMEOUT, try calls included
+    */
+    uint64_t getTimeoutCount() const
+    {
+        return timeouts.load(std::memory_order_relaxed);
+    }
+
+    //
+    // Input channels
+    //
+    int getInputGain(int inputChannel, int* const gain, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return getInt(wait(queue.getInputGainAsync(inputChannel), deadlineMilliseconds), gain);
+    }
+
+    int tryGetInputGain(int inputChannel, int* const gain)
+    {
+        Key key { AIOFunction_AIO_getInputGain, inputChannel, 0, 0, 0.0 };
+        return getInt(poll(key, [&]() { return queue.getInputGainAsync(inputChannel); }), gain);
+    }
+
+    int setInputGain(int inputChannel, int gain, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return wait(queue.setInputGainAsync(inputChannel, gain), deadlineMilliseconds).status;
+    }
+
+    int trySetInputGain(int inputChannel, int gain)
+    {
+        Key key { AIOFunction_AIO_setInputGain, inputChannel, 0, gain, 0.0 };
+        return poll(key, [&]() { return queue.setInputGainAsync(inputChannel, gain); }).status;
+    }
+
+    int getConstantCurrentState(int inputChannel, int* const enabled, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return getInt(wait(queue.getConstantCurrentStateAsync(inputChannel), deadlineMilliseconds), enabled);
+    }
+
+    int tryGetConstantCurrentState(int inputChannel, int* const enabled)
+    {
+        Key key { AIOFunction_AIO_getConstantCurrentState, inputChannel, 0, 0, 0.0 };
+        return getInt(poll(key, [&]() { return queue.getConstantCurrentStateAsync(inputChannel); }), enabled);
+    }
+
+    int setConstantCurrentState(int inputChannel, int enabled, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return wait(queue.setConstantCurrentStateAsync(inputChannel, enabled), deadlineMilliseconds).status;
+    }
+
+    int trySetConstantCurrentState(int inputChannel, int enabled)
+    {
+        Key key { AIOFunction_AIO_setConstantCurrentState, inputChannel, 0, enabled, 0.0 };
+        return poll(key, [&]() { return queue.setConstantCurrentStateAsync(inputChannel, enabled); }).status;
+    }
+
+    int getTEDSProperties(int inputChannel, char* const jsonText, size_t jsonBufferBytes, size_t* jsonBytesRequired,
+        int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return getText(wait(queue.getTEDSPropertiesAsync(inputChannel), deadlineMilliseconds), jsonText, jsonBufferBytes, jsonBytesRequired);
+    }
+
+    int tryGetTEDSProperties(int inputChannel, char* const jsonText, size_t jsonBufferBytes, size_t* jsonBytesRequired)
+    {
+        Key key { AIOFunction_AIO_getTEDSProperties, inputChannel, 0, 0, 0.0 };
+        return getText(poll(key, [&]() { return queue.getTEDSPropertiesAsync(inputChannel); }), jsonText, jsonBufferBytes, jsonBytesRequired);
+    }
+
+    //
+    // Output channels
+    //
+    int getOutputGain(int outputChannel, int* const gain, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return getInt(wait(queue.getOutputGainAsync(outputChannel), deadlineMilliseconds), gain);
+    }
+
+    int tryGetOutputGain(int outputChannel, int* const gain)
+    {
+        Key key { AIOFunction_AIO_getOutputGain, outputChannel, 0, 0, 0.0 };
+        return getInt(poll(key, [&]() { return queue.getOutputGainAsync(outputChannel); }), gain);
+    }
+
+    int setOutputGain(int outputChannel, int gain, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return wait(queue.setOutputGainAsync(outputChannel, gain), deadlineMilliseconds).status;
+    }
+
+    int trySetOutputGain(int outputChannel, int gain)
+    {
+        Key key { AIOFunction_AIO_setOutputGain, outputChannel, 0, gain, 0.0 };
+        return poll(key, [&]() { return queue.setOutputGainAsync(outputChannel, gain); }).status;
+    }
+
+    int getOutputLimitVolts(int outputChannel, double* const limitVolts, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return getDouble(wait(queue.getOutputLimitVoltsAsync(outputChannel), deadlineMilliseconds), limitVolts);
+    }
+
+    int tryGetOutputLimitVolts(int outputChannel, double* const limitVolts)
+    {
+        Key key { AIOFunction_AIO_getOutputLimitVolts, outputChannel, 0, 0, 0.0 };
+        return getDouble(poll(key, [&]() { return queue.getOutputLimitVoltsAsync(outputChannel); }), limitVolts);
+    }
+
+    int setOutputLimitVolts(int outputChannel, double limitVolts, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return wait(queue.setOutputLimitVoltsAsync(outputChannel, limitVolts), deadlineMilliseconds).status;
+    }
+
+    int trySetOutputLimitVolts(int outputChannel, double limitVolts)
+    {
+        Key key { AIOFunction_AIO_setOutputLimitVolts, outputChannel, 0, 0, limitVolts };
+        return poll(key, [&]() { return queue.setOutputLimitVoltsAsync(outputChannel, limitVolts); }).status;
+    }
+
+    //
+    // Module parameters
+    //
+    int getModuleIntParameter(int moduleSlot, int parameter, int* const value, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return getInt(wait(queue.getModuleIntParameterAsync(moduleSlot, parameter), deadlineMilliseconds), value);
+    }
+
+    int tryGetModuleIntParameter(int moduleSlot, int parameter, int* const value)
+    {
+        Key key { AIOFunction_AIO_getModuleIntParameter, moduleSlot, parameter, 0, 0.0 };
+        return getInt(poll(key, [&]() { return queue.getModuleIntParameterAsync(moduleSlot, parameter); }), value);
+    }
+
+    int setModuleIntParameter(int moduleSlot, int parameter, int value, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return wait(queue.setModuleIntParameterAsync(moduleSlot, parameter, value), deadlineMilliseconds).status;
+    }
+
+    int trySetModuleIntParameter(int moduleSlot, int parameter, int value)
+    {
+        Key key { AIOFunction_AIO_setModuleIntParameter, moduleSlot, parameter, value, 0.0 };
+        return poll(key, [&]() { return queue.setModuleIntParameterAsync(moduleSlot, parameter, value); }).status;
+    }
+
+    int getModuleDoubleParameter(int moduleSlot, int parameter, double* const value, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return getDouble(wait(queue.getModuleDoubleParameterAsync(moduleSlot, parameter), deadlineMilliseconds), value);
+    }
+
+    int tryGetModuleDoubleParameter(int moduleSlot, int parameter, double* const value)
+    {
+        Key key { AIOFunction_AIO_getModuleDoubleParameter, moduleSlot, parameter, 0, 0.0 };
+        return getDouble(poll(key, [&]() { return queue.getModuleDoubleParameterAsync(moduleSlot, parameter); }), value);
+    }
+
+    int setModuleDoubleParameter(int moduleSlot, int parameter, double value, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return wait(queue.setModuleDoubleParameterAsync(moduleSlot, parameter, value), deadlineMilliseconds).status;
+    }
+
+    int trySetModuleDoubleParameter(int moduleSlot, int parameter, double value)
+    {
+        Key key { AIOFunction_AIO_setModuleDoubleParameter, moduleSlot, parameter, 0, value };
+        return poll(key, [&]() { return queue.setModuleDoubleParameterAsync(moduleSlot, parameter, value); }).status;
+    }
+
+    int updateTDM(int moduleSlot, int deadlineMilliseconds = AIO_DEFAULT_DEADLINE)
+    {
+        return wait(queue.updateTDMAsync(moduleSlot), deadlineMilliseconds).status;
+    }
+
+    int tryUpdateTDM(int moduleSlot)
+    {
+        Key key { AIOFunction_AIO_updateTDM, moduleSlot, 0, 0, 0.0 };
+        return poll(key, [&]() { return queue.updateTDMAsync(moduleSlot); }).status;
+    }
+
+private:
+    //
+    // Identifies a try call, so a repeated call with the same arguments collects the call already started
+    //
+    struct Key
+    {
+        int function;
+        int channel;        // channel or module slot
+        int parameter;
+        int intValue;
+        double doubleValue;
+
+        bool operator==(const Key& other) const
+        {
+            return function == other.function && channel == other.channel && parameter == other.parameter &&
+                intValue == other.intValue && doubleValue == other.doubleValue;
+        }
+
+        bool isSameControl(const Key& other) const
+        {
+            return function == other.function && channel == other.channel && parameter == other.parameter;
+        }
+    };
+
+    struct Pending
+    {
+        Key key;
+        std::future<AIOCommandResult> result;
+    };
+
+    AIOCommandResult timedOut()
+    {
+        timeouts.fetch_add(1, std::memory_order_relaxed);
+        AIOCommandResult result;
+        result.status = ECHO_AIO_TIMEOUT;
+        return result;
+    }
+
+    AIOCommandResult wait(std::future<AIOCommandResult> future, int deadlineMilliseconds)
+    {
+        if (AIO_DEFAULT_DEADLINE == deadlineMilliseconds)
+        {
+            deadlineMilliseconds = getDefaultDeadline();
+        }
+        if (deadlineMilliseconds > 0 &&
+            std::future_status::ready != future.wait_for(std::chrono::milliseconds(deadlineMilliseconds)))
+        {
+            return timedOut();
+        }
+        return future.get();
+    }
+
+    template <typename Start>
+    AIOCommandResult poll(const Key& key, Start start)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        size_t index = 0;
+        while (index < pending.size() && false == pending[index].key.isSameControl(key))
+        {
+            ++index;
+        }
+        if (index == pending.size())
+        {
+            pending.push_back(Pending { key, start() });
+        }
+        else if (false == (pending[index].key == key))
+        {
+            pending[index] = Pending { key, start() };
+        }
+
+        if (std::future_status::ready != pending[index].result.wait_for(std::chrono::seconds(0)))
+        {
+            return timedOut();
+        }
+
+        AIOCommandResult result = pending[index].result.get();
+        pending.erase(pending.begin() + index);
+        return result;
+    }
+
+    static int getInt(const AIOCommandResult& result, int* const value)
+    {
+        if (ECHO_AIO_OK == result.status && value)
+        {
+            *value = result.intValue;
+        }
+        return result.status;
+    }
+
+    static int getDouble(const AIOCommandResult& result, double* const value)
+    {
+        if (ECHO_AIO_OK == result.status && value)
+        {
+            *value = result.doubleValue;
+        }
+        return result.status;
+    }
+
+    //
+    // Same buffer rules as AIO_getTEDSProperties
+    //
+    static int getText(const AIOCommandResult& result, char* const jsonText, size_t jsonBufferBytes, size_t* jsonBytesRequired)
+    {
+        if (ECHO_AIO_OK != result.status)
+        {
+            return result.status;
+        }
+
+        size_t required = result.text.size() + 1;
+        if (jsonBytesRequired)
+        {
+            *jsonBytesRequired = required;
+        }
+        if (nullptr == jsonText)
+        {
+            return ECHO_AIO_OK;
+        }
+        if (jsonBufferBytes < required)
+        {
+            return ECHO_AIO_BUFFER_TOO_SMALL;
+        }
+
+        std::memcpy(jsonText, result.text.c_str(), required);
+        return ECHO_AIO_OK;
+    }
+
+    AIOCommandQueue queue;
+    std::atomic<int> defaultDeadline;
+    std::atomic<uint64_t> timeouts { 0 };
+    std::mutex lock;
+    std::vector<Pending> pending;
+};
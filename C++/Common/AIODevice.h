@@ -0,0 +1,255 @@
+/*
+  ==============================================================================
+
+    AIODevice - drive several AIO units from one process
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AIOApi.h"
+
+/*
+    AIODevice
+
+    One AIO unit. The library API addresses a single unit per loaded library, so each AIODevice owns its own
+    library instance (see AIOApi::openLibraryInstance) and its own AIOApi table. Every call made through
+    api() targets this unit. Devices share no state and no lock, so separate threads can drive separate units
+    in parallel, each over its own USB pipe.
+
+    The serial number is the only thing that tells units apart; AIODeviceList never returns a device without
+    one.
+*/
+class AIODevice
+{
+public:
+    ~AIODevice()
+    {
+        if (handle)
+        {
+            table.AIO_shutdown();
+            AIOApi::closeLibrary(handle);
+        }
+    }
+
+    AIODevice(const AIODevice&) = delete;
+    AIODevice& operator=(const AIODevice&) = delete;
+
+    /*
+        getSerialNumber
+
+        Returns the serial number of the first AIO-C module, or -1 if the unit has no AIO-C module
+    */
+    int getSerialNumber() const
+    {
+        return serialNumber;
+    }
+
+    const std::string& getLibraryPath() const
+    {
+        return libraryPath;
+    }
+
+    const AIOApi& api() const
+    {
+        return table;
+    }
+
+private:
+    friend class AIODeviceList;
+
+    AIODevice() = default;
+
+    AIOLibraryHandle handle = nullptr;
+    AIOApi table;
+    std::string libraryPath;
+    int serialNumber = -1;
+};
+
+/*
+    AIODeviceList
+
+    Finds and owns the AIO units available to this process. Devices remain valid until the list is destroyed
+    or enumerateDevices is called again.
+
+    The library has no call that picks a unit: AIO_initialize in every instance opens the first AIO it finds,
+    so with real hardware each instance reaches the same unit. Driving several units from one process is
+    therefore only supported with the emulator (C++/Emulator), where each instance is its own emulated unit;
+    give each one a different serialNumber option from the prepare callback. With hardware, expect one device.
+*/
+class AIODeviceList
+{
+public:
+    using PrepareCallback = void (*)(AIOLibraryHandle handle, int index, void* context);
+
+    /*
+        enumerateDevices
+
+        Parameters
+            libraryPaths    One library per unit; see AIOApi::openLibraryInstance
+            error           Receives a description of any library that could not be loaded
+            prepare         Optional function called for each library after it loads and before AIO_initialize
+                            (for example, to configure an emulated unit)
+            context         Passed unchanged to prepare
+
+        Loads every library instance and runs AIO_initialize for all of them in parallel. A library that
+        loads as the same module as an earlier one (the same file on macOS or Windows) is rejected before it
+        is initialized, since shutting down one device would shut down the other. Units that report no AIO
+        connected, that have no AIO-C serial number, or that report a serial number already taken by an
+        earlier unit (a second instance that reached the same AIO) are dropped and described in error.
+
+        Returns the number of devices found
+    */
+    int enumerateDevices(const std::vector<std::string>& libraryPaths, std::string& error,
+        PrepareCallback prepare = nullptr, void* context = nullptr)
+    {
+        devices.clear();
+
+        std::vector<std::unique_ptr<AIODevice>> candidates;
+        for (size_t index = 0; index < libraryPaths.size(); ++index)
+        {
+            std::unique_ptr<AIODevice> device(new AIODevice);
+            device->libraryPath = libraryPaths[index];
+            device->handle = AIOApi::openLibraryInstance(device->libraryPath.c_str());
+            if (nullptr == device->handle)
+            {
+                error += "Unable to load Echo AIO library " + device->libraryPath + "\n";
+                continue;
+            }
+
+            //
+            // The loader hands back the module it already has for the same file; the earlier device owns it
+            //
+            bool shared = false;
+            for (const auto& candidate : candidates)
+            {
+                shared = shared || candidate->handle == device->handle;
+            }
+            if (shared)
+            {
+                error += device->libraryPath + ": shares a module with an earlier library; use a separate copy of the file\n";
+                AIOApi::closeLibrary(device->handle);
+                device->handle = nullptr;
+                continue;
+            }
+
+            std::string resolveError;
+            if (false == device->table.resolve(device->handle, resolveError))
+            {
+                error += device->libraryPath + ": " + resolveError + "\n";
+                AIOApi::closeLibrary(device->handle);
+                device->handle = nullptr;
+                continue;
+            }
+
+            if (prepare)
+            {
+                prepare(device->handle, static_cast<int>(index), context);
+            }
+            candidates.push_back(std::move(device));
+        }
+
+        //
+        // USB enumeration and module discovery run in parallel for every unit
+        //
+        std::vector<std::thread> threads;
+        for (auto& candidate : candidates)
+        {
+            AIODevice* device = candidate.get();
+            threads.emplace_back([device]()
+                {
+                    device->table.AIO_initialize();
+                    for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+                    {
+                        int serialNumber = -1;
+                        if (device->table.AIO_hasComboModule(slot) &&
+                            ECHO_AIO_OK == device->table.AIO_getModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_SERIAL_NUMBER, &serialNumber))
+                        {
+                            device->serialNumber = serialNumber;
+                            break;
+                        }
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (auto& candidate : candidates)
+        {
+            if (false == candidate->table.AIO_isAIOConnected())
+            {
+                error += candidate->libraryPath + ": no AIO connected\n";
+                continue;
+            }
+
+            if (-1 == candidate->serialNumber)
+            {
+                error += candidate->libraryPath + ": unit has no AIO-C serial number\n";
+                continue;
+            }
+
+            if (openDevice(candidate->serialNumber))
+            {
+                error += candidate->libraryPath + ": serial number " + std::to_string(candidate->serialNumber) +
+                    " already belongs to an earlier unit\n";
+                continue;
+            }
+
+            devices.push_back(std::move(candidate));
+        }
+
+        return getNumDevices();
+    }
+
+    int getNumDevices() const
+    {
+        return static_cast<int>(devices.size());
+    }
+
+    AIODevice* getDevice(int index) const
+    {
+        return index >= 0 && index < getNumDevices() ? devices[index].get() : nullptr;
+    }
+
+    std::vector<int> getSerialNumbers() const
+    {
+        std::vector<int> serialNumbers;
+        for (const auto& device : devices)
+        {
+            serialNumbers.push_back(device->getSerialNumber());
+        }
+        return serialNumbers;
+    }
+
+    /*
+        openDevice
+
+        Parameters
+            serialNumber    Serial number reported by getSerialNumbers
+
+        Returns the device, or nullptr if no enumerated unit has that serial number
+    */
+    AIODevice* openDevice(int serialNumber) const
+    {
+        for (const auto& device : devices)
+        {
+            if (device->getSerialNumber() == serialNumber)
+            {
+                return device.get();
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    std::vector<std::unique_ptr<AIODevice>> devices;
+};
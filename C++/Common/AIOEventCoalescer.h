@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    AIOEventCoalescer - merges bursts of AIO events into one per control
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AIOEvents.h"
+
+/*
+    AIOEventCoalescer
+
+    Sits between an event source and its listeners, for example
+
+        snapshot.registerChangeCallback(AIOEventCoalescer::onEvent, AIO_EVENT_ALL, &coalescer);
+        coalescer.registerCallback(onKnobChanged, AIO_EVENT_INPUT_GAIN, context);
+
+    The first event after a quiet period opens a window of windowMilliseconds. Events that arrive during the
+    window are merged per control (same type, channel, and parameter): each control is delivered once when the
+    window closes, with its latest value and a mergedCount of the events it replaced. Controls are delivered in
+    the order they first changed within the window. A window of 0 passes every event straight through.
+
+    Edge events (AIO_EVENT_OVER_CURRENT, AIO_EVENT_CONNECTION, AIO_EVENT_MODULE) are never merged, since a trip
+    and its clear, or an unplug and a replug, would otherwise merge into one event that hides the edge. Each
+    one closes the current window and is delivered at once, right after that window's events.
+
+    Callbacks run on the coalescer's thread, or on the thread that calls flush, one at a time.
+*/
+class AIOEventCoalescer
+{
+public:
+    explicit AIOEventCoalescer(int windowMilliseconds = 50) :
+        window(windowMilliseconds > 0 ? windowMilliseconds : 0)
+    {
+        if (window.count())
+        {
+            windowThread = std::thread(&AIOEventCoalescer::run, this);
+        }
+    }
+
+    ~AIOEventCoalescer()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (windowThread.joinable())
+        {
+            windowThread.join();
+        }
+    }
+
+    AIOEventCoalescer(const AIOEventCoalescer&) = delete;
+    AIOEventCoalescer& operator=(const AIOEventCoalescer&) = delete;
+
+    int registerCallback(AIOEventDispatcher::Callback callback, int mask, void* context)
+    {
+        return events.registerCallback(callback, mask, context);
+    }
+
+    bool unregisterCallback(int id)
+    {
+        return events.unregisterCallback(id);
+    }
+
+    /*
+        push
+
+        Adds an event to the current window, opening one if none is open, or delivers an edge event at once;
+        may be called from any thread
+    */
+    void push(const AIOEvent& event)
+    {
+        if (0 == window.count() || isEdge(event))
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                ++received;
+                post();
+                ++delivered;
+                events.post({ event });
+            }
+            events.drain();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ++received;
+            for (auto& entry : merged)
+            {
+                if (entry.type == event.type && entry.channel == event.channel && entry.parameter == event.parameter)
+                {
+                    int32_t count = entry.mergedCount + event.mergedCount;
+                    entry = event;
+                    entry.mergedCount = count;
+                    return;
+                }
+            }
+
+            if (merged.empty())
+            {
+                windowEnd = std::chrono::steady_clock::now() + window;
+            }
+            merged.push_back(event);
+        }
+        wake.notify_one();
+    }
+
+    static void onEvent(const AIOEvent& event, void* context)
+    {
+        static_cast<AIOEventCoalescer*>(context)->push(event);
+    }
+
+    /*
+        flush
+
+        Closes the current window and delivers its events on the calling thread
+    */
+    void flush()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            post();
+        }
+        events.drain();
+    }
+
+    /*
+        getReceivedCount
+        getDeliveredCount
+
+        Returns the number of events pushed, and the number delivered after merging
+    */
+    uint64_t getReceivedCount()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return received;
+    }
+
+    uint64_t getDeliveredCount()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return delivered;
+    }
+
+private:
+    static bool isEdge(const AIOEvent& event)
+    {
+        return 0 != (event.type & (AIO_EVENT_OVER_CURRENT | AIO_EVENT_CONNECTION | AIO_EVENT_MODULE));
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (false == stopping)
+        {
+            if (merged.empty())
+            {
+                wake.wait(guard);
+                continue;
+            }
+
+            auto end = windowEnd;
+            if (std::chrono::steady_clock::now() < end)
+            {
+                wake.wait_until(guard, end);
+                continue;
+            }
+
+            post();
+            guard.unlock();
+            events.drain();
+            guard.lock();
+        }
+    }
+
+    //
+    // Called with lock held; posting under the lock keeps windows in order when flush races the window thread
+    //
+    void post()
+    {
+        if (merged.empty())
+        {
+            return;
+        }
+
+        delivered += merged.size();
+        events.post(merged);
+        merged.clear();
+    }
+
+    const std::chrono::milliseconds window;
+    AIOEventDispatcher events;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<AIOEvent> merged;       // current window, in order of first change
+    std::chrono::steady_clock::time_point windowEnd;
+    uint64_t received = 0;
+    uint64_t delivered = 0;
+    bool stopping = false;
+    std::thread windowThread;
+};
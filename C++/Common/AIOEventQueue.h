@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    AIOEventQueue - AIO events for a poll, epoll, or kqueue event loop
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include "AIOEvents.h"
+
+#if _WIN32
+#include <Windows.h>
+#elif __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+    AIOEventQueue
+
+    Holds events until an event loop reads them. Register onEvent as a change callback, for example
+
+        snapshot.registerChangeCallback(AIOEventQueue::onEvent, AIO_EVENT_ALL, &queue);
+
+    then add getFileDescriptor to the loop's poll, epoll, or kqueue set. The descriptor is readable while at
+    least one event is waiting, and readEvents copies them out in the order they happened. On Linux the
+    descriptor is an eventfd, on other POSIX systems the read end of a pipe; on Windows getEventHandle returns
+    an event object that is signaled while events are waiting.
+
+    Only readEvents may be used on the descriptor; do not read from it directly. If more than capacity events
+    are waiting, the oldest are dropped and counted.
+*/
+class AIOEventQueue
+{
+public:
+    explicit AIOEventQueue(size_t capacity_ = 1024) :
+        capacity(capacity_ ? capacity_ : 1)
+    {
+#if _WIN32
+        handle = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+#elif __linux__
+        readDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        writeDescriptor = readDescriptor;
+#else
+        int descriptors[2];
+        if (0 == pipe(descriptors))
+        {
+            for (int descriptor : descriptors)
+            {
+                fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+                fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+            }
+            readDescriptor = descriptors[0];
+            writeDescriptor = descriptors[1];
+        }
+#endif
+    }
+
+    ~AIOEventQueue()
+    {
+#if _WIN32
+        if (handle)
+        {
+            CloseHandle(handle);
+        }
+#else
+        if (readDescriptor >= 0)
+        {
+            close(readDescriptor);
+        }
+        if (writeDescriptor >= 0 && writeDescriptor != readDescriptor)
+        {
+            close(writeDescriptor);
+        }
+#endif
+    }
+
+    AIOEventQueue(const AIOEventQueue&) = delete;
+    AIOEventQueue& operator=(const AIOEventQueue&) = delete;
+
+#if _WIN32
+    HANDLE getEventHandle() const
+    {
+        return handle;
+    }
+#else
+    /*
+        getFileDescriptor
+
+        Returns the descriptor to poll for readability, or -1 if it could not be created
+    */
+    int getFileDescriptor() const
+    {
+        return readDescriptor;
+    }
+#endif
+
+    /*
+        readEvents
+
+        Parameters
+            events          Receives up to maxEvents events, oldest first
+            maxEvents       Size of the events array
+
+        Never blocks. The descriptor stops being readable once every waiting event has been read.
+
+        Returns the number of events copied; 0 if none were waiting
+    */
+    int readEvents(AIOEvent* const events, int maxEvents)
+    {
+        if (nullptr == events || maxEvents <= 0)
+        {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        int count = 0;
+        while (count < maxEvents && false == waiting.empty())
+        {
+            events[count++] = waiting.front();
+            waiting.pop_front();
+        }
+        if (count && waiting.empty())
+        {
+            clearSignal();
+        }
+        return count;
+    }
+
+    /*
+        push
+
+        Adds an event; may be called from any thread
+    */
+    void push(const AIOEvent& event)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (waiting.size() == capacity)
+        {
+            waiting.pop_front();
+            ++dropped;
+        }
+        waiting.push_back(event);
+        if (1 == waiting.size())
+        {
+            setSignal();
+        }
+    }
+
+    static void onEvent(const AIOEvent& event, void* context)
+    {
+        static_cast<AIOEventQueue*>(context)->push(event);
+    }
+
+    uint64_t getDroppedCount()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return dropped;
+    }
+
+private:
+    //
+    // Both called with lock held: the descriptor is readable exactly while waiting is not empty
+    //
+    void setSignal()
+    {
+#if _WIN32
+        SetEvent(handle);
+#else
+#if __linux__
+        uint64_t one = 1;       // eventfd takes exactly eight bytes
+#else
+        char one = 1;
+#endif
+        ssize_t written = write(writeDescriptor, &one, sizeof(one));
+        (void)written;
+#endif
+    }
+
+    void clearSignal()
+    {
+#if _WIN32
+        ResetEvent(handle);
+#else
+        uint64_t value = 0;
+        ssize_t bytesRead = read(readDescriptor, &value, sizeof(value));
+        (void)bytesRead;
+#endif
+    }
+
+    size_t capacity;
+    std::mutex lock;
+    std::deque<AIOEvent> waiting;
+    uint64_t dropped = 0;
+#if _WIN32
+    HANDLE handle = nullptr;
+#else
+    int readDescriptor = -1;
+    int writeDescriptor = -1;
+#endif
+};
@@ -0,0 +1,310 @@
+/*
+  ==============================================================================
+
+    AIOEvents - control change events and their delivery to callbacks
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "AIOControlState.h"
+
+enum AIOEventType
+{
+    AIO_EVENT_INPUT_GAIN = 0x01,
+    AIO_EVENT_CONSTANT_CURRENT = 0x02,
+    AIO_EVENT_OUTPUT_LIMIT = 0x04,
+    AIO_EVENT_MODULE_PARAMETER = 0x08,
+    AIO_EVENT_AUX_IN = 0x10,
+    AIO_EVENT_OVER_CURRENT = 0x20,
+    AIO_EVENT_CONNECTION = 0x40,
+    AIO_EVENT_MODULE = 0x80,
+
+    AIO_EVENT_ALL = 0xff
+};
+
+/*
+    AIOEvent
+
+    One control that changed, with its new value. Plain data, so events can be copied into caller arrays.
+    timestamp is std::chrono::steady_clock time in nanoseconds, taken when the change was seen; the library
+    reports no device time, so for a value found by polling it is the time of the read that found it.
+*/
+struct AIOEvent
+{
+    int32_t type;               // one AIOEventType bit
+    int32_t channel;            // input or output channel, or module slot
+    int32_t parameter;          // module parameter for parameter events, otherwise 0
+    int32_t intValue;           // new value of an int control; 1 or 0 for a connection, AIOModuleType for a module
+    double doubleValue;         // new value of the output limit or a double module parameter
+    int32_t mergedCount = 1;    // number of changes this event stands for; more than 1 after AIOEventCoalescer
+    int64_t timestamp = 0;      // when the change was seen; see now
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+/*
+    AIOStateChanges
+
+    Compares two AIOControlState copies
+*/
+struct AIOStateChanges
+{
+    /*
+        getParameterEventType
+
+        Returns the AIOEventType reported when a module parameter changes, or 0 for one that is not reported
+    */
+    static int getParameterEventType(int parameter)
+    {
+        switch (parameter)
+        {
+        case AIO_COMBO_MODULE_PARAMETER_AUX_IN:
+            return AIO_EVENT_AUX_IN;
+
+        case AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION:
+            return AIO_EVENT_OVER_CURRENT;
+
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_MILLIVOLTS:
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT:
+            return 0;
+        }
+        return AIO_EVENT_MODULE_PARAMETER;
+    }
+
+    /*
+        find
+
+        Appends one event for each control whose value differs between before and after. Module parameters are
+        only compared while the slot holds the same module type. AUX IN and the over current condition are
+        reported as AIO_EVENT_AUX_IN and AIO_EVENT_OVER_CURRENT; the measured voltage and current are not
+        reported, since they change on every read.
+    */
+    static void find(const AIOControlState& before, const AIOControlState& after, std::vector<AIOEvent>& events)
+    {
+        for (int channel = 0; channel < after.numInputChannels; ++channel)
+        {
+            if (before.inputGain[channel] != after.inputGain[channel])
+            {
+                events.push_back(AIOEvent { AIO_EVENT_INPUT_GAIN, channel, 0, after.inputGain[channel], 0.0 });
+            }
+            if (before.constantCurrent[channel] != after.constantCurrent[channel])
+            {
+                events.push_back(AIOEvent { AIO_EVENT_CONSTANT_CURRENT, channel, 0, after.constantCurrent[channel], 0.0 });
+            }
+        }
+
+        for (int channel = 0; channel < after.numOutputChannels; ++channel)
+        {
+            if (before.outputLimitVolts[channel] != after.outputLimitVolts[channel])
+            {
+                events.push_back(AIOEvent { AIO_EVENT_OUTPUT_LIMIT, channel, 0, 0, after.outputLimitVolts[channel] });
+            }
+        }
+
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            const AIOModuleState& old = before.modules[slot];
+            const AIOModuleState& module = after.modules[slot];
+            if (AIO_MODULE_NONE == module.type || old.type != module.type)
+            {
+                continue;
+            }
+
+            for (int parameter = AIOControlState::getFirstParameter(module.type); parameter <= AIOControlState::getLastParameter(module.type); ++parameter)
+            {
+                int index = AIOControlState::getParameterIndex(parameter);
+                int type = getParameterEventType(parameter);
+                if (0 == type)
+                {
+                    continue;
+                }
+                if (AIOControlState::isDoubleParameter(parameter))
+                {
+                    if (old.doubleParameters[index] != module.doubleParameters[index])
+                    {
+                        events.push_back(AIOEvent { type, slot, parameter, 0, module.doubleParameters[index] });
+                    }
+                }
+                else if (old.intParameters[index] != module.intParameters[index])
+                {
+                    events.push_back(AIOEvent { type, slot, parameter, module.intParameters[index], 0.0 });
+                }
+            }
+        }
+    }
+};
+
+/*
+    AIOEventDispatcher
+
+    Delivers events to registered callbacks. Any thread may post events; they are delivered in the order they
+    were posted, by whichever thread calls drain first, one callback at a time. A callback may register or
+    unregister callbacks and may post more events, which are delivered after the current ones. Once
+    unregisterCallback returns, that callback is not called again.
+*/
+class AIOEventDispatcher
+{
+public:
+    using Callback = void (*)(const AIOEvent& event, void* context);
+
+    AIOEventDispatcher() = default;
+    AIOEventDispatcher(const AIOEventDispatcher&) = delete;
+    AIOEventDispatcher& operator=(const AIOEventDispatcher&) = delete;
+
+    /*
+        registerCallback
+
+        Parameters
+            callback        Called once for each event whose type is in mask
+            mask            AIOEventType bits
+            context         Passed to callback
+
+        Returns a registration number for unregisterCallback, or 0 if callback is null
+    */
+    int registerCallback(Callback callback, int mask, void* context)
+    {
+        if (nullptr == callback)
+        {
+            return 0;
+        }
+
+        std::lock_guard<std::recursive_mutex> guard(callbackLock);
+        listeners.push_back(Listener { ++lastId, callback, mask, context });
+        updateMask();
+        return lastId;
+    }
+
+    /*
+        unregisterCallback
+
+        Returns true if id was registered
+    */
+    bool unregisterCallback(int id)
+    {
+        std::lock_guard<std::recursive_mutex> guard(callbackLock);
+        for (size_t index = 0; index < listeners.size(); ++index)
+        {
+            if (listeners[index].id == id)
+            {
+                listeners.erase(listeners.begin() + index);
+                updateMask();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+        getMask
+
+        Returns the event types at least one callback is registered for; never locks, so event sources can
+        call it while holding their own locks
+    */
+    int getMask() const
+    {
+        return combinedMask.load(std::memory_order_relaxed);
+    }
+
+    void post(const std::vector<AIOEvent>& events)
+    {
+        std::lock_guard<std::mutex> guard(pendingLock);
+        pending.insert(pending.end(), events.begin(), events.end());
+    }
+
+    /*
+        drain
+
+        Delivers every posted event; returns at once if another thread is already delivering
+    */
+    void drain()
+    {
+        std::unique_lock<std::mutex> guard(pendingLock);
+        if (draining)
+        {
+            return;
+        }
+
+        draining = true;
+        std::vector<AIOEvent> events;
+        while (false == pending.empty())
+        {
+            events.swap(pending);
+            guard.unlock();
+            deliver(events);
+            events.clear();
+            guard.lock();
+        }
+        draining = false;
+    }
+
+private:
+    struct Listener
+    {
+        int id;
+        Callback callback;
+        int mask;
+        void* context;
+    };
+
+    void updateMask()
+    {
+        int mask = 0;
+        for (const auto& listener : listeners)
+        {
+            mask |= listener.mask;
+        }
+        combinedMask.store(mask, std::memory_order_relaxed);
+    }
+
+    void deliver(const std::vector<AIOEvent>& events)
+    {
+        std::lock_guard<std::recursive_mutex> guard(callbackLock);
+        for (const auto& event : events)
+        {
+            //
+            // Walk a copy, since a callback may change the list; skip any listener a callback has unregistered
+            //
+            std::vector<Listener> current = listeners;
+            for (const auto& listener : current)
+            {
+                if ((listener.mask & event.type) && isRegistered(listener.id))
+                {
+                    listener.callback(event, listener.context);
+                }
+            }
+        }
+    }
+
+    bool isRegistered(int id) const
+    {
+        for (const auto& listener : listeners)
+        {
+            if (listener.id == id)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::recursive_mutex callbackLock;
+    std::vector<Listener> listeners;
+    int lastId = 0;
+    std::atomic<int> combinedMask { 0 };
+
+    std::mutex pendingLock;
+    std::vector<AIOEvent> pending;
+    bool draining = false;
+};
@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+    AIOHotplug - unit and module connect and disconnect callbacks
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AIOApi.h"
+#include "AIOEvents.h"
+#include "AIONotification.h"
+#include "AIOTopology.h"
+
+/*
+    AIOHotplugMonitor
+
+    Watches for the AIO being unplugged and plugged back in, and for modules being removed, inserted, or swapped,
+    and keeps an AIOTopology of the connected unit up to date.
+
+    start reads the full topology once. After that, each check calls only the discovery functions
+    (AIO_isAIOConnected, AIO_hasComboModule, AIO_hasTModule), and re-queries only what they show has changed:
+
+        - A slot whose module type changed is queried again with AIOTopology::queryModule; the other slot keeps
+          its cached entry.
+        - When the unit comes back, the channel counts are read again and each occupied slot is identified
+          again in case its module was swapped for another of the same type. The cached TEDS properties are
+          dropped, since a sensor may have been swapped while the unit was unplugged, but not read again until
+          getTEDS asks for a channel; the events are delivered without waiting for any TEDS read. TEDS changes
+          raise no event.
+
+    registerCallback reports AIO_EVENT_CONNECTION (channel 0, intValue 1 when the unit is connected, 0 when it is
+    unplugged) and AIO_EVENT_MODULE (channel is the slot, intValue the new AIOModuleType). Unplugging the unit
+    reports only the connection; slots that differ when it comes back are reported then. Callbacks run on the
+    monitor thread, one at a time, and may pass events to an AIOEventQueue.
+
+    Checks run every pollMilliseconds, each time the library broadcasts AIO_notificationString (on Windows and
+    macOS), and when check is called.
+*/
+class AIOHotplugMonitor
+{
+public:
+    explicit AIOHotplugMonitor(const AIOApi& api_) :
+        api(api_)
+    {
+    }
+
+    ~AIOHotplugMonitor()
+    {
+        stop();
+    }
+
+    AIOHotplugMonitor(const AIOHotplugMonitor&) = delete;
+    AIOHotplugMonitor& operator=(const AIOHotplugMonitor&) = delete;
+
+    /*
+        start
+
+        Parameters
+            pollMilliseconds        Time between checks; 0 checks only on a broadcast or check call
+
+        Reads the full topology before returning; call after AIO_initialize
+
+        Returns false if already started
+    */
+    bool start(int pollMilliseconds = 500)
+    {
+        if (monitorThread.joinable())
+        {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(topologyLock);
+            connected = 0 != api.AIO_isAIOConnected();
+            topology = connected ? AIOTopology::query(api) : AIOTopology {};
+            tedsStale.assign(topology.teds.size(), false);
+        }
+
+        pollInterval = std::chrono::milliseconds(pollMilliseconds);
+        stopping = false;
+        checkRequested = false;
+        monitorThread = std::thread(&AIOHotplugMonitor::run, this);
+        listener.start(&AIOHotplugMonitor::onNotification, this);
+        return true;
+    }
+
+    void stop()
+    {
+        listener.stop();
+        {
+            std::lock_guard<std::mutex> guard(checkLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (monitorThread.joinable())
+        {
+            monitorThread.join();
+        }
+    }
+
+    /*
+        check
+
+        Asks the monitor thread to check for changes; returns at once
+    */
+    void check()
+    {
+        {
+            std::lock_guard<std::mutex> guard(checkLock);
+            checkRequested = true;
+        }
+        wake.notify_one();
+    }
+
+    static void onNotification(void* context)
+    {
+        static_cast<AIOHotplugMonitor*>(context)->check();
+    }
+
+    /*
+        registerCallback
+
+        Parameters
+            callback        Called once for each event whose type is in mask
+            mask            AIO_EVENT_CONNECTION, AIO_EVENT_MODULE, or both
+            context         Passed to callback
+
+        Returns a registration number for unregisterCallback, or 0 if callback is null
+    */
+    int registerCallback(AIOEventDispatcher::Callback callback, int mask, void* context)
+    {
+        return events.registerCallback(callback, mask, context);
+    }
+
+    bool unregisterCallback(int id)
+    {
+        return events.unregisterCallback(id);
+    }
+
+    bool isConnected()
+    {
+        std::lock_guard<std::mutex> guard(topologyLock);
+        return connected;
+    }
+
+    /*
+        getTopology
+
+        Returns the topology of the connected unit as of the last check; the last known topology while it is
+        unplugged. After a replug, the TEDS entry of each channel is empty until getTEDS has read it.
+    */
+    AIOTopology getTopology()
+    {
+        std::lock_guard<std::mutex> guard(topologyLock);
+        return topology;
+    }
+
+    /*
+        getTEDS
+
+        Parameters
+            inputChannel    Input channel
+
+        The first call for a channel after a replug reads its TEDS properties from the unit, without holding up
+        the monitor or other callers; later calls return the cached text.
+
+        Returns the TEDS properties as JSON text, or an empty string if the channel has no TEDS
+    */
+    std::string getTEDS(int inputChannel)
+    {
+        uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> guard(topologyLock);
+            if (inputChannel < 0 || inputChannel >= static_cast<int>(topology.teds.size()))
+            {
+                return {};
+            }
+            if (false == tedsStale[inputChannel])
+            {
+                return topology.teds[inputChannel];
+            }
+            generation = reconnects;
+        }
+
+        std::string teds = AIOTopology::queryTEDS(api, inputChannel);
+
+        //
+        // Keep the text only if the unit was not unplugged or replugged during the read
+        //
+        std::lock_guard<std::mutex> guard(topologyLock);
+        if (connected && generation == reconnects)
+        {
+            topology.teds[inputChannel] = teds;
+            tedsStale[inputChannel] = false;
+        }
+        return teds;
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> guard(checkLock);
+        while (false == stopping)
+        {
+            auto requested = [this]() { return stopping || checkRequested; };
+            if (pollInterval.count())
+            {
+                wake.wait_for(guard, pollInterval, requested);
+            }
+            else
+            {
+                wake.wait(guard, requested);
+            }
+            if (stopping)
+            {
+                break;
+            }
+
+            checkRequested = false;
+            guard.unlock();
+            update();
+            guard.lock();
+        }
+    }
+
+    static int getModuleType(const AIOApi& api, int slot)
+    {
+        if (api.AIO_hasComboModule(slot))
+        {
+            return AIO_MODULE_COMBO;
+        }
+        if (api.AIO_hasTModule(slot))
+        {
+            return AIO_MODULE_T;
+        }
+        return AIO_MODULE_NONE;
+    }
+
+    void update()
+    {
+        std::vector<AIOEvent> changed;
+        bool nowConnected = 0 != api.AIO_isAIOConnected();
+        {
+            std::lock_guard<std::mutex> guard(topologyLock);
+            bool reconnected = nowConnected && false == connected;
+            if (nowConnected != connected)
+            {
+                connected = nowConnected;
+                changed.push_back(AIOEvent { AIO_EVENT_CONNECTION, 0, 0, connected ? 1 : 0, 0.0 });
+            }
+
+            if (connected)
+            {
+                if (reconnected)
+                {
+                    updateChannels();
+                }
+                updateModules(reconnected, changed);
+            }
+        }
+
+        if (false == changed.empty())
+        {
+            int64_t timestamp = AIOEvent::now();
+            for (auto& event : changed)
+            {
+                event.timestamp = timestamp;
+            }
+            events.post(changed);
+            events.drain();
+        }
+    }
+
+    //
+    // Called with topologyLock held after a reconnect; getTEDS reads the TEDS of each channel later
+    //
+    void updateChannels()
+    {
+        topology.numInputChannels = api.AIO_getNumInputChannels();
+        topology.numOutputChannels = api.AIO_getNumOutputChannels();
+        topology.teds.assign(topology.numInputChannels > 0 ? topology.numInputChannels : 0, {});
+        tedsStale.assign(topology.teds.size(), true);
+        ++reconnects;
+    }
+
+    //
+    // Called with topologyLock held
+    //
+    void updateModules(bool reconnected, std::vector<AIOEvent>& changed)
+    {
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            int type = getModuleType(api, slot);
+            AIOModuleTopology& cached = topology.modules[slot];
+            if (type == cached.type && (false == reconnected || AIO_MODULE_NONE == type))
+            {
+                continue;
+            }
+
+            AIOModuleTopology module = AIOTopology::queryModule(api, slot);
+            if (module == cached)
+            {
+                continue;
+            }
+
+            cached = module;
+            changed.push_back(AIOEvent { AIO_EVENT_MODULE, slot, 0, module.type, 0.0 });
+        }
+    }
+
+    const AIOApi& api;
+
+    std::mutex topologyLock;
+    bool connected = false;
+    AIOTopology topology;
+    std::vector<bool> tedsStale;        // TEDS entries not read since the last reconnect
+    uint64_t reconnects = 0;
+
+    AIOEventDispatcher events;
+
+    std::mutex checkLock;
+    std::condition_variable wake;
+    std::chrono::milliseconds pollInterval {};
+    bool checkRequested = false;
+    bool stopping = false;
+    std::thread monitorThread;
+    AIONotificationListener listener;
+};
@@ -0,0 +1,486 @@
+/*
+  ==============================================================================
+
+    AIOInstrumentation - per-function call statistics for the EchoAIOInterface
+    library
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include "AIOApi.h"
+#include "AIOTrace.h"
+
+enum
+{
+    AIO_STATISTICS_STATUS_CODES = 16,       // ECHO_AIO_* codes 0 - 14; 15 counts anything else
+    AIO_STATISTICS_HISTOGRAM_BUCKETS = 32   // bucket n counts calls from 2^(n-1) up to 2^n nanoseconds
+};
+
+/*
+    AIOFunctionStatistics
+
+    Totals for one library function
+*/
+struct AIOFunctionStatistics
+{
+    uint64_t calls;
+    uint64_t statusCounts[AIO_STATISTICS_STATUS_CODES];     // calls that returned each ECHO_AIO_* code
+    uint64_t transfers;                                     // calls that sent a USB command to the unit
+    uint64_t bytes;                                         // text bytes returned through caller buffers
+    uint64_t totalNanoseconds;
+    uint64_t maxNanoseconds;
+    uint64_t histogram[AIO_STATISTICS_HISTOGRAM_BUCKETS];
+
+    uint64_t getErrorCount() const
+    {
+        return calls - statusCounts[ECHO_AIO_OK];
+    }
+};
+
+struct AIOStatistics
+{
+    AIOFunctionStatistics functions[AIOFunction_count];
+};
+
+/*
+    AIOInstrumentation
+
+    instrument wraps a resolved AIOApi table so every call through the returned table is counted and timed.
+    Calls made through the original table are not counted.
+
+    Each thread updates its own block of counters with plain relaxed stores; there is no lock, no write to a
+    shared cache line, and no read-modify-write instruction on the call path, so the cost is about two clock
+    reads per call.
+    Readers add the blocks together; getStatistics and resetStatistics never stop a calling thread.
+
+    While an AIOTrace is open, the same calls are also recorded on the trace timeline.
+
+    One library is instrumented per process; call instrument once, before the returned table is used.
+*/
+class AIOInstrumentation
+{
+public:
+    /*
+        instrument
+
+        Parameters
+            target          Resolved table for the library to measure; copied
+
+        Returns a table with the same functions and libraryVersion that records every call
+    */
+    static AIOApi instrument(const AIOApi& target)
+    {
+        getTarget() = target;
+
+        AIOApi table;
+#define AIO_INSTRUMENTATION_SET_POINTER(name) \
+        table.name = &AIOInstrumentedCall<AIOFunction_##name, decltype(AIOApi::name), &AIOApi::name>::call;
+        AIO_API_FUNCTIONS(AIO_INSTRUMENTATION_SET_POINTER)
+#undef AIO_INSTRUMENTATION_SET_POINTER
+        table.libraryVersion = target.libraryVersion;
+        return table;
+    }
+
+    /*
+        getStatistics
+
+        Parameters
+            jsonText            Points to a buffer to receive the statistics as JSON-formatted text
+            jsonBufferBytes     Length of the JSON text buffer in bytes
+            jsonBytesRequired   Points to a value to receive the number of bytes needed for the JSON text buffer
+
+        Both jsonText and jsonBytesRequired are optional parameters, as for AIO_getTEDSProperties. Functions that
+        have not been called since the last reset are left out.
+
+        Returns 0 if successful, or ECHO_AIO_BUFFER_TOO_SMALL
+    */
+    static int getStatistics(char* const jsonText, size_t jsonBufferBytes, size_t* jsonBytesRequired)
+    {
+        std::string json = formatJSON(getStatistics());
+
+        size_t required = json.size() + 1;
+        if (jsonBytesRequired)
+        {
+            *jsonBytesRequired = required;
+        }
+        if (nullptr == jsonText)
+        {
+            return ECHO_AIO_OK;
+        }
+        if (jsonBufferBytes < required)
+        {
+            return ECHO_AIO_BUFFER_TOO_SMALL;
+        }
+
+        std::memcpy(jsonText, json.c_str(), required);
+        return ECHO_AIO_OK;
+    }
+
+    /*
+        getStatistics
+
+        Returns the totals since the last reset
+    */
+    static AIOStatistics getStatistics()
+    {
+        Shared& shared = getShared();
+        std::lock_guard<std::mutex> guard(shared.readerLock);
+
+        AIOStatistics statistics;
+        sum(statistics);
+        for (int function = 0; function < AIOFunction_count; ++function)
+        {
+            AIOFunctionStatistics& totals = statistics.functions[function];
+            const AIOFunctionStatistics& baseline = shared.baseline.functions[function];
+            totals.calls -= baseline.calls;
+            for (int code = 0; code < AIO_STATISTICS_STATUS_CODES; ++code)
+            {
+                totals.statusCounts[code] -= baseline.statusCounts[code];
+            }
+            totals.transfers -= baseline.transfers;
+            totals.bytes -= baseline.bytes;
+            totals.totalNanoseconds -= baseline.totalNanoseconds;
+            for (int bucket = 0; bucket < AIO_STATISTICS_HISTOGRAM_BUCKETS; ++bucket)
+            {
+                totals.histogram[bucket] -= baseline.histogram[bucket];
+            }
+        }
+        return statistics;
+    }
+
+    /*
+        resetStatistics
+
+        Starts the totals again from zero. Counters are never written by the reader; the current totals become the
+        baseline that later reads subtract, and each thread clears its own maximum latency on its next call.
+    */
+    static void resetStatistics()
+    {
+        Shared& shared = getShared();
+        std::lock_guard<std::mutex> guard(shared.readerLock);
+        shared.epoch.fetch_add(1, std::memory_order_relaxed);
+        sum(shared.baseline);
+    }
+
+    /*
+        returnsStatus
+
+        Returns true for functions whose int return value is an ECHO_AIO_* code rather than a count or flag
+    */
+    static constexpr bool returnsStatus(int function)
+    {
+        switch (function)
+        {
+        case AIOFunction_AIO_getInputGain:
+        case AIOFunction_AIO_setInputGain:
+        case AIOFunction_AIO_getConstantCurrentState:
+        case AIOFunction_AIO_setConstantCurrentState:
+        case AIOFunction_AIO_getTEDSProperties:
+        case AIOFunction_AIO_getOutputGain:
+        case AIOFunction_AIO_setOutputGain:
+        case AIOFunction_AIO_getOutputLimitVolts:
+        case AIOFunction_AIO_setOutputLimitVolts:
+#if _WIN32
+        case AIOFunction_AIO_setASIOPreferredBufferSize:
+        case AIOFunction_AIO_setSampleRate:
+#endif
+        case AIOFunction_AIO_getModuleIntParameter:
+        case AIOFunction_AIO_setModuleIntParameter:
+        case AIOFunction_AIO_getModuleDoubleParameter:
+        case AIOFunction_AIO_setModuleDoubleParameter:
+        case AIOFunction_AIO_updateTDM:
+            return true;
+        }
+        return false;
+    }
+
+    /*
+        sendsCommand
+
+        Returns true for functions that exchange a USB command with the unit. The interface does not report
+        retries, so each such call counts as one transfer.
+    */
+    static constexpr bool sendsCommand(int function)
+    {
+#if _WIN32
+        if (AIOFunction_AIO_setASIOPreferredBufferSize == function || AIOFunction_AIO_setSampleRate == function)
+        {
+            return false;
+        }
+#endif
+        return returnsStatus(function);
+    }
+
+private:
+    struct Counters
+    {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> statusCounts[AIO_STATISTICS_STATUS_CODES];
+        std::atomic<uint64_t> transfers;
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> totalNanoseconds;
+        std::atomic<uint64_t> maxNanoseconds;
+        std::atomic<uint64_t> histogram[AIO_STATISTICS_HISTOGRAM_BUCKETS];
+    };
+
+    //
+    // One block per thread; blocks go on a list that only grows, and a block is handed to a new thread
+    // once its previous owner has exited, so the totals it holds are kept
+    //
+    struct ThreadCounters
+    {
+        std::atomic<bool> inUse { true };
+        std::atomic<uint32_t> epoch { 0 };
+        ThreadCounters* next = nullptr;
+        Counters functions[AIOFunction_count] {};
+    };
+
+    struct ThreadCountersOwner
+    {
+        ThreadCounters* counters = nullptr;
+
+        ~ThreadCountersOwner()
+        {
+            if (counters)
+            {
+                counters->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    struct Shared
+    {
+        std::atomic<ThreadCounters*> head { nullptr };
+        std::atomic<uint32_t> epoch { 0 };
+        std::mutex readerLock;
+        AIOStatistics baseline {};
+    };
+
+    template <int Function, typename Pointer, Pointer AIOApi::* Member>
+    struct AIOInstrumentedCall;
+
+    template <int Function, typename Result, typename... Args, Result (*AIOApi::* Member)(Args...)>
+    struct AIOInstrumentedCall<Function, Result (*)(Args...), Member>
+    {
+        static Result call(Args... args)
+        {
+            auto function = getTarget().*Member;
+            auto start = std::chrono::steady_clock::now();
+            if constexpr (std::is_void<Result>::value)
+            {
+                function(args...);
+                record(Function, ECHO_AIO_OK, start, getTextBytes(args...));
+            }
+            else
+            {
+                Result result = function(args...);
+                int status = returnsStatus(Function) ? static_cast<int>(result) : ECHO_AIO_OK;
+                record(Function, status, start, ECHO_AIO_OK == status ? getTextBytes(args...) : 0);
+                return result;
+            }
+        }
+    };
+
+    //
+    // Text returned through a caller's buffer: AIO_getLibraryVersion and AIO_getErrorString fill text,
+    // AIO_getTEDSProperties reports the size it needs
+    //
+    template <typename... Args>
+    static uint64_t getTextBytes(Args...)
+    {
+        return 0;
+    }
+
+    static uint64_t getTextBytes(char* const text, size_t textBufferBytes)
+    {
+        return text && textBufferBytes ? strnlen(text, textBufferBytes) : 0;
+    }
+
+    static uint64_t getTextBytes(int, char* const jsonText, size_t, size_t* jsonBytesRequired)
+    {
+        return jsonText && jsonBytesRequired ? *jsonBytesRequired : 0;
+    }
+
+    static void increment(std::atomic<uint64_t>& counter, uint64_t amount = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static void record(int function, int status, std::chrono::steady_clock::time_point start, uint64_t bytes)
+    {
+        auto end = std::chrono::steady_clock::now();
+        if (AIOTrace::isEnabled())
+        {
+            AIOTrace::record(function, status, sendsCommand(function), start, end);
+        }
+
+        uint64_t nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+        int bucket = 0;
+        while (bucket < AIO_STATISTICS_HISTOGRAM_BUCKETS - 1 && (nanoseconds >> bucket))
+        {
+            ++bucket;
+        }
+
+        ThreadCounters& block = getThreadCounters();
+        uint32_t epoch = getShared().epoch.load(std::memory_order_relaxed);
+        if (block.epoch.load(std::memory_order_relaxed) != epoch)
+        {
+            for (auto& functionCounters : block.functions)
+            {
+                functionCounters.maxNanoseconds.store(0, std::memory_order_relaxed);
+            }
+            block.epoch.store(epoch, std::memory_order_relaxed);
+        }
+
+        Counters& counters = block.functions[function];
+        increment(counters.calls);
+        increment(counters.statusCounts[status >= 0 && status < AIO_STATISTICS_STATUS_CODES - 1 ? status : AIO_STATISTICS_STATUS_CODES - 1]);
+        if (sendsCommand(function))
+        {
+            increment(counters.transfers);
+        }
+        if (bytes)
+        {
+            increment(counters.bytes, bytes);
+        }
+        increment(counters.totalNanoseconds, nanoseconds);
+        increment(counters.histogram[bucket]);
+        if (nanoseconds > counters.maxNanoseconds.load(std::memory_order_relaxed))
+        {
+            counters.maxNanoseconds.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    static ThreadCounters& getThreadCounters()
+    {
+        thread_local ThreadCountersOwner owner;
+        if (owner.counters)
+        {
+            return *owner.counters;
+        }
+
+        Shared& shared = getShared();
+        for (ThreadCounters* block = shared.head.load(std::memory_order_acquire); block; block = block->next)
+        {
+            bool expected = false;
+            if (block->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                owner.counters = block;
+                return *block;
+            }
+        }
+
+        ThreadCounters* block = new ThreadCounters;
+        block->next = shared.head.load(std::memory_order_relaxed);
+        while (false == shared.head.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        owner.counters = block;
+        return *block;
+    }
+
+    static void sum(AIOStatistics& statistics)
+    {
+        std::memset(&statistics, 0, sizeof(statistics));
+        Shared& shared = getShared();
+        uint32_t epoch = shared.epoch.load(std::memory_order_relaxed);
+        for (ThreadCounters* block = shared.head.load(std::memory_order_acquire); block; block = block->next)
+        {
+            bool currentEpoch = block->epoch.load(std::memory_order_relaxed) == epoch;
+            for (int function = 0; function < AIOFunction_count; ++function)
+            {
+                const Counters& counters = block->functions[function];
+                AIOFunctionStatistics& totals = statistics.functions[function];
+                totals.calls += counters.calls.load(std::memory_order_relaxed);
+                for (int code = 0; code < AIO_STATISTICS_STATUS_CODES; ++code)
+                {
+                    totals.statusCounts[code] += counters.statusCounts[code].load(std::memory_order_relaxed);
+                }
+                totals.transfers += counters.transfers.load(std::memory_order_relaxed);
+                totals.bytes += counters.bytes.load(std::memory_order_relaxed);
+                totals.totalNanoseconds += counters.totalNanoseconds.load(std::memory_order_relaxed);
+                if (currentEpoch)
+                {
+                    totals.maxNanoseconds = std::max<uint64_t>(totals.maxNanoseconds, counters.maxNanoseconds.load(std::memory_order_relaxed));
+                }
+                for (int bucket = 0; bucket < AIO_STATISTICS_HISTOGRAM_BUCKETS; ++bucket)
+                {
+                    totals.histogram[bucket] += counters.histogram[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    static std::string formatJSON(const AIOStatistics& statistics)
+    {
+        std::string json = "{\"functions\":[";
+        bool first = true;
+        for (int function = 0; function < AIOFunction_count; ++function)
+        {
+            const AIOFunctionStatistics& totals = statistics.functions[function];
+            if (0 == totals.calls)
+            {
+                continue;
+            }
+
+            json += first ? "{" : ",{";
+            first = false;
+            json += "\"name\":\"" + std::string(getAIOFunctionName(function)) + "\"";
+            json += ",\"calls\":" + std::to_string(totals.calls);
+            json += ",\"errors\":" + std::to_string(totals.getErrorCount());
+            json += ",\"statusCounts\":{";
+            bool firstCode = true;
+            for (int code = 0; code < AIO_STATISTICS_STATUS_CODES; ++code)
+            {
+                if (totals.statusCounts[code])
+                {
+                    json += (firstCode ? "\"" : ",\"") + std::to_string(code) + "\":" + std::to_string(totals.statusCounts[code]);
+                    firstCode = false;
+                }
+            }
+            json += "}";
+            json += ",\"transfers\":" + std::to_string(totals.transfers);
+            json += ",\"bytes\":" + std::to_string(totals.bytes);
+            json += ",\"totalNanoseconds\":" + std::to_string(totals.totalNanoseconds);
+            json += ",\"maxNanoseconds\":" + std::to_string(totals.maxNanoseconds);
+            json += ",\"histogram\":[";
+            int lastBucket = AIO_STATISTICS_HISTOGRAM_BUCKETS - 1;
+            while (lastBucket > 0 && 0 == totals.histogram[lastBucket])
+            {
+                --lastBucket;
+            }
+            for (int bucket = 0; bucket <= lastBucket; ++bucket)
+            {
+                json += (bucket ? "," : "") + std::to_string(totals.histogram[bucket]);
+            }
+            json += "]}";
+        }
+        json += "]}";
+        return json;
+    }
+
+    static AIOApi& getTarget()
+    {
+        static AIOApi target;
+        return target;
+    }
+
+    static Shared& getShared()
+    {
+        static Shared shared;
+        return shared;
+    }
+};
@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    AIOLanes - per-channel and per-slot serialization of library calls
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <mutex>
+#include "AIOApi.h"
+#include "AIOControlState.h"
+
+/*
+    AIOLanes
+
+    Thread-safety guarantees for calls made through this object:
+
+        - Each input channel, each output channel, and each module slot is a lane. Calls on one lane run one
+          at a time, in no particular order; calls on different lanes never wait for each other here. Streaming
+          AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT from slot 0 therefore never waits behind
+          a reconfiguration of the module in slot 1.
+
+        - lockInputChannel, lockOutputChannel, and lockModuleSlot hold a lane across several calls, so a
+          sequence such as setting AIO-T parameters and then calling AIO_updateTDM cannot interleave with
+          another thread's calls to that slot. The lock is recursive: calls through this object on the same
+          lane from the holding thread proceed.
+
+        - A thread that holds a lane and makes a call on another lane holds two lanes at once. Take lanes in
+          this order only: input channels, then output channels, then module slots, each in increasing number.
+          A thread that holds slot 0 and calls setInputGain(1) breaks this order, and can deadlock with a
+          thread that holds input 1 and calls into slot 0.
+
+        - Discovery functions (AIO_isAIOConnected, AIO_has*, channel counts) and AIO_initialize/AIO_shutdown
+          take no lane; do not call AIO_shutdown while other threads are making calls.
+
+    Library requirement: with AIO_LANE_PER_TARGET (the default), calls on different lanes reach the library
+    from several threads at once, so the library must be safe to call concurrently for different channels and
+    slots. EchoAIOInterface.h does not promise this. For a library that is not, or has not been shown to be,
+    pass AIO_SINGLE_LANE: every call and every lock then goes through one lane, as with a single client-side
+    mutex, and the guarantees above still hold with "lane" meaning the whole library.
+
+    Lanes only order calls on the client side. Whether calls on different lanes overlap on the device depends
+    on the library: if it serializes every call behind one lock of its own, they still run one at a time. The
+    emulator's commandLanes option models either behavior.
+*/
+class AIOLanes
+{
+public:
+    enum LaneMode
+    {
+        AIO_LANE_PER_TARGET,        // a lane per input channel, output channel, and module slot
+        AIO_SINGLE_LANE             // one lane for every call
+    };
+
+    explicit AIOLanes(const AIOApi& api_, LaneMode laneMode_ = AIO_LANE_PER_TARGET) :
+        api(api_),
+        laneMode(laneMode_)
+    {
+    }
+
+    AIOLanes(const AIOLanes&) = delete;
+    AIOLanes& operator=(const AIOLanes&) = delete;
+
+    using Lock = std::unique_lock<std::recursive_mutex>;
+
+    /*
+        lockInputChannel, lockOutputChannel, lockModuleSlot
+
+        Returns a lock that holds the lane until it is destroyed; for an out-of-range channel or slot the lock
+        holds nothing, unless there is a single lane
+    */
+    Lock lockInputChannel(int inputChannel)
+    {
+        return lock(isChannel(inputChannel) ? &inputLanes[inputChannel] : nullptr);
+    }
+
+    Lock lockOutputChannel(int outputChannel)
+    {
+        return lock(isChannel(outputChannel) ? &outputLanes[outputChannel] : nullptr);
+    }
+
+    Lock lockModuleSlot(int moduleSlot)
+    {
+        return lock(moduleSlot >= 0 && moduleSlot < AIO_numModuleSlots ? &slotLanes[moduleSlot] : nullptr);
+    }
+
+    //
+    // Input channels; same parameters and return values as the library functions
+    //
+    int getInputGain(int inputChannel, int* const gain)
+    {
+        Lock guard = lockInputChannel(inputChannel);
+        return api.AIO_getInputGain(inputChannel, gain);
+    }
+
+    int setInputGain(int inputChannel, int gain)
+    {
+        Lock guard = lockInputChannel(inputChannel);
+        return api.AIO_setInputGain(inputChannel, gain);
+    }
+
+    int getConstantCurrentState(int inputChannel, int* const enabled)
+    {
+        Lock guard = lockInputChannel(inputChannel);
+        return api.AIO_getConstantCurrentState(inputChannel, enabled);
+    }
+
+    int setConstantCurrentState(int inputChannel, int enabled)
+    {
+        Lock guard = lockInputChannel(inputChannel);
+        return api.AIO_setConstantCurrentState(inputChannel, enabled);
+    }
+
+    int getTEDSProperties(int inputChannel, char* const jsonText, size_t jsonBufferBytes, size_t* jsonBytesRequired)
+    {
+        Lock guard = lockInputChannel(inputChannel);
+        return api.AIO_getTEDSProperties(inputChannel, jsonText, jsonBufferBytes, jsonBytesRequired);
+    }
+
+    //
+    // Output channels
+    //
+    int getOutputGain(int outputChannel, int* const gain)
+    {
+        Lock guard = lockOutputChannel(outputChannel);
+        return api.AIO_getOutputGain(outputChannel, gain);
+    }
+
+    int setOutputGain(int outputChannel, int gain)
+    {
+        Lock guard = lockOutputChannel(outputChannel);
+        return api.AIO_setOutputGain(outputChannel, gain);
+    }
+
+    int getOutputLimitVolts(int outputChannel, double* const limitVolts)
+    {
+        Lock guard = lockOutputChannel(outputChannel);
+        return api.AIO_getOutputLimitVolts(outputChannel, limitVolts);
+    }
+
+    int setOutputLimitVolts(int outputChannel, double limitVolts)
+    {
+        Lock guard = lockOutputChannel(outputChannel);
+        return api.AIO_setOutputLimitVolts(outputChannel, limitVolts);
+    }
+
+    //
+    // Module parameters
+    //
+    int getModuleIntParameter(int moduleSlot, int parameter, int* const value)
+    {
+        Lock guard = lockModuleSlot(moduleSlot);
+        return api.AIO_getModuleIntParameter(moduleSlot, parameter, value);
+    }
+
+    int setModuleIntParameter(int moduleSlot, int parameter, int value)
+    {
+        Lock guard = lockModuleSlot(moduleSlot);
+        return api.AIO_setModuleIntParameter(moduleSlot, parameter, value);
+    }
+
+    int getModuleDoubleParameter(int moduleSlot, int parameter, double* const value)
+    {
+        Lock guard = lockModuleSlot(moduleSlot);
+        return api.AIO_getModuleDoubleParameter(moduleSlot, parameter, value);
+    }
+
+    int setModuleDoubleParameter(int moduleSlot, int parameter, double value)
+    {
+        Lock guard = lockModuleSlot(moduleSlot);
+        return api.AIO_setModuleDoubleParameter(moduleSlot, parameter, value);
+    }
+
+    int updateTDM(int moduleSlot)
+    {
+        Lock guard = lockModuleSlot(moduleSlot);
+        return api.AIO_updateTDM(moduleSlot);
+    }
+
+private:
+    static bool isChannel(int channel)
+    {
+        return channel >= 0 && channel < AIO_MAX_CHANNELS;
+    }
+
+    Lock lock(std::recursive_mutex* lane)
+    {
+        if (AIO_SINGLE_LANE == laneMode)
+        {
+            return Lock(singleLane);
+        }
+        return lane ? Lock(*lane) : Lock();
+    }
+
+    const AIOApi& api;
+    const LaneMode laneMode;
+    std::recursive_mutex singleLane;
+    std::recursive_mutex inputLanes[AIO_MAX_CHANNELS];
+    std::recursive_mutex outputLanes[AIO_MAX_CHANNELS];
+    std::recursive_mutex slotLanes[AIO_numModuleSlots];
+};
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    AIONotification - receive the library's control change broadcast
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include "AIOApi.h"
+
+#if __APPLE__
+#include <CoreFoundation/CoreFoundation.h>
+#endif
+
+/*
+    AIONotificationListener
+
+    Calls a function each time the library broadcasts AIO_notificationString ("Echo AIO control change"), which
+    it does when any client changes a control. The listener runs its own thread: a hidden top-level window on
+    Windows (broadcast window messages do not reach message-only windows) and a run loop observing the
+    distributed notification center on macOS; link with CoreFoundation on macOS.
+
+    Other platforms have no broadcast; start returns false there, and callers should fall back to polling.
+
+    The callback runs on the listener thread; it should be quick and must not call stop.
+*/
+class AIONotificationListener
+{
+public:
+    using Callback = void (*)(void* context);
+
+    AIONotificationListener() = default;
+
+    ~AIONotificationListener()
+    {
+        stop();
+    }
+
+    AIONotificationListener(const AIONotificationListener&) = delete;
+    AIONotificationListener& operator=(const AIONotificationListener&) = delete;
+
+    /*
+        start
+
+        Parameters
+            callback    Function to call for each broadcast
+            context     Passed unchanged to callback
+
+        Returns true if the listener is running
+    */
+    bool start(Callback callback, void* context)
+    {
+        stop();
+        notify = callback;
+        notifyContext = context;
+
+#if _WIN32 || __APPLE__
+        std::promise<bool> started;
+        auto result = started.get_future();
+        thread = std::thread(&AIONotificationListener::run, this, std::move(started));
+        if (false == result.get())
+        {
+            thread.join();
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void stop()
+    {
+        if (false == thread.joinable())
+        {
+            return;
+        }
+
+#if _WIN32
+        PostThreadMessageA(threadId, WM_QUIT, 0, 0);
+#elif __APPLE__
+        stopping.store(true);
+        CFRunLoopStop(runLoop);
+#endif
+        thread.join();
+    }
+
+    bool isRunning() const
+    {
+        return thread.joinable();
+    }
+
+private:
+#if _WIN32
+    void run(std::promise<bool> started)
+    {
+        message = RegisterWindowMessageA(AIO_notificationString);
+        threadId = GetCurrentThreadId();
+
+        WNDCLASSA windowClass {};
+        windowClass.lpfnWndProc = &AIONotificationListener::windowProc;
+        windowClass.hInstance = GetModuleHandleA(nullptr);
+        windowClass.lpszClassName = "AIONotificationListener";
+        RegisterClassA(&windowClass);
+
+        HWND window = CreateWindowExA(0, windowClass.lpszClassName, "", WS_POPUP, 0, 0, 0, 0, nullptr, nullptr, windowClass.hInstance, nullptr);
+        if (nullptr == window || 0 == message)
+        {
+            started.set_value(false);
+            return;
+        }
+        SetWindowLongPtrA(window, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+        //
+        // Make sure the thread has a message queue before start returns so stop can always post WM_QUIT
+        //
+        MSG msg;
+        PeekMessageA(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+        started.set_value(true);
+
+        while (GetMessageA(&msg, nullptr, 0, 0) > 0)
+        {
+            DispatchMessageA(&msg);
+        }
+        DestroyWindow(window);
+    }
+
+    static LRESULT CALLBACK windowProc(HWND window, UINT windowMessage, WPARAM wParam, LPARAM lParam)
+    {
+        auto listener = reinterpret_cast<AIONotificationListener*>(GetWindowLongPtrA(window, GWLP_USERDATA));
+        if (listener && windowMessage == listener->message)
+        {
+            listener->notify(listener->notifyContext);
+            return 0;
+        }
+        return DefWindowProcA(window, windowMessage, wParam, lParam);
+    }
+
+    UINT message = 0;
+    DWORD threadId = 0;
+#elif __APPLE__
+    void run(std::promise<bool> started)
+    {
+        runLoop = CFRunLoopGetCurrent();
+        CFStringRef name = CFStringCreateWithCString(kCFAllocatorDefault, AIO_notificationString, kCFStringEncodingUTF8);
+        CFNotificationCenterRef center = CFNotificationCenterGetDistributedCenter();
+        CFNotificationCenterAddObserver(center, this, &AIONotificationListener::observe, name, nullptr,
+            CFNotificationSuspensionBehaviorDeliverImmediately);
+
+        //
+        // A timer that never fires keeps the run loop from returning before stop is called
+        //
+        CFRunLoopTimerRef keepAlive = CFRunLoopTimerCreate(kCFAllocatorDefault, 1.0e10, 1.0e10, 0, 0, nullptr, nullptr);
+        CFRunLoopAddTimer(runLoop, keepAlive, kCFRunLoopDefaultMode);
+
+        //
+        // Short run loop passes so a stop that arrives before the loop first runs is still seen
+        //
+        stopping.store(false);
+        started.set_value(true);
+        while (false == stopping.load())
+        {
+            CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.25, false);
+        }
+
+        CFRunLoopRemoveTimer(runLoop, keepAlive, kCFRunLoopDefaultMode);
+        CFRelease(keepAlive);
+        CFNotificationCenterRemoveObserver(center, this, name, nullptr);
+        CFRelease(name);
+    }
+
+    static void observe(CFNotificationCenterRef, void* observer, CFNotificationName, const void*, CFDictionaryRef)
+    {
+        auto listener = static_cast<AIONotificationListener*>(observer);
+        listener->notify(listener->notifyContext);
+    }
+
+    CFRunLoopRef runLoop = nullptr;
+    std::atomic<bool> stopping { false };
+#endif
+
+    Callback notify = nullptr;
+    void* notifyContext = nullptr;
+    std::thread thread;
+};
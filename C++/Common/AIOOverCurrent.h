@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    AIOOverCurrent - over current events for the AIO-C variable DC supply
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AIOApi.h"
+#include "AIOEvents.h"
+
+enum AIOOverCurrentPolicy
+{
+    AIO_OVER_CURRENT_REPORT,            // report the trip; the application decides what to do
+    AIO_OVER_CURRENT_DISABLE_POWER      // turn off the variable DC supply, then report the trip
+};
+
+/*
+    AIOOverCurrentMonitor
+
+    Reports AIO_EVENT_OVER_CURRENT (channel is the module slot, intValue 1 when the AIO-C module trips and 0 when
+    the condition is cleared) with the time it was seen in the event timestamp.
+
+    The library has no interrupt for the over current condition, so a monitor thread reads
+    AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION from each AIO-C module every pollMilliseconds: one USB
+    command per module per poll and nothing else. A trip is seen at most one poll interval plus one command after
+    it happens, and the timestamp is taken as soon as the read that found it returns.
+
+    With AIO_OVER_CURRENT_DISABLE_POWER the monitor thread sets AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE
+    to 0 right after that read, before any callback runs, and reports the supply turning off as an
+    AIO_EVENT_MODULE_PARAMETER event with intValue 0. For as long as the condition stays set, each poll also checks
+    the supply and turns it off again if it was turned back on. If the write fails it is retried on every poll,
+    and an AIO_EVENT_MODULE_PARAMETER event with intValue 1 reports that the supply may still be on. The
+    application still clears the condition. A failed read of the condition keeps the last known state.
+
+    Callbacks run on the monitor thread, one at a time.
+*/
+class AIOOverCurrentMonitor
+{
+public:
+    explicit AIOOverCurrentMonitor(const AIOApi& api_, AIOOverCurrentPolicy policy_ = AIO_OVER_CURRENT_REPORT) :
+        api(api_),
+        policy(policy_)
+    {
+    }
+
+    ~AIOOverCurrentMonitor()
+    {
+        stop();
+    }
+
+    AIOOverCurrentMonitor(const AIOOverCurrentMonitor&) = delete;
+    AIOOverCurrentMonitor& operator=(const AIOOverCurrentMonitor&) = delete;
+
+    /*
+        start
+
+        Parameters
+            pollMilliseconds        Time between reads of each module's over current condition
+
+        Call after AIO_initialize
+
+        Returns false if already started
+    */
+    bool start(int pollMilliseconds = 5)
+    {
+        if (monitorThread.joinable())
+        {
+            return false;
+        }
+
+        pollInterval = std::chrono::milliseconds(pollMilliseconds > 0 ? pollMilliseconds : 1);
+        stopping = false;
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            trippedSlots[slot] = false;
+            poweredOffSlots[slot] = false;
+            disableFailedSlots[slot] = false;
+        }
+        monitorThread = std::thread(&AIOOverCurrentMonitor::run, this);
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> guard(stopLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (monitorThread.joinable())
+        {
+            monitorThread.join();
+        }
+    }
+
+    /*
+        registerCallback
+
+        Parameters
+            callback        Called once for each event whose type is in mask
+            mask            AIO_EVENT_OVER_CURRENT, plus AIO_EVENT_MODULE_PARAMETER for the supply turning off
+            context         Passed to callback
+
+        Returns a registration number for unregisterCallback, or 0 if callback is null
+    */
+    int registerCallback(AIOEventDispatcher::Callback callback, int mask, void* context)
+    {
+        return events.registerCallback(callback, mask, context);
+    }
+
+    bool unregisterCallback(int id)
+    {
+        return events.unregisterCallback(id);
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> guard(stopLock);
+        while (false == stopping)
+        {
+            guard.unlock();
+            poll();
+            guard.lock();
+            wake.wait_for(guard, pollInterval, [this]() { return stopping; });
+        }
+    }
+
+    void poll()
+    {
+        std::vector<AIOEvent> changed;
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            if (false == api.AIO_hasComboModule(slot))
+            {
+                trippedSlots[slot] = false;
+                poweredOffSlots[slot] = false;
+                disableFailedSlots[slot] = false;
+                continue;
+            }
+
+            //
+            // A failed read keeps the last known state
+            //
+            int condition = 0;
+            if (ECHO_AIO_OK == api.AIO_getModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION, &condition) &&
+                (0 != condition) != trippedSlots[slot])
+            {
+                trippedSlots[slot] = 0 != condition;
+                poweredOffSlots[slot] = false;
+                AIOEvent event { AIO_EVENT_OVER_CURRENT, slot, AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION, condition ? 1 : 0, 0.0 };
+                event.timestamp = AIOEvent::now();
+                changed.push_back(event);
+            }
+
+            if (trippedSlots[slot] && AIO_OVER_CURRENT_DISABLE_POWER == policy)
+            {
+                enforcePowerOff(slot, changed);
+            }
+        }
+
+        if (false == changed.empty())
+        {
+            events.post(changed);
+            events.drain();
+        }
+    }
+
+    //
+    // Called on every poll while the condition is set. The first time, the supply is turned off without reading
+    // it first; after that it is read, and turned off again if the application turned it back on. A failed write
+    // is retried on the next poll and reported once per run of failures.
+    //
+    void enforcePowerOff(int slot, std::vector<AIOEvent>& changed)
+    {
+        int enabled = 1;
+        if (poweredOffSlots[slot] &&
+            ECHO_AIO_OK == api.AIO_getModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, &enabled) &&
+            0 == enabled)
+        {
+            return;
+        }
+
+        if (ECHO_AIO_OK == api.AIO_setModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 0))
+        {
+            poweredOffSlots[slot] = true;
+            disableFailedSlots[slot] = false;
+            AIOEvent disabled { AIO_EVENT_MODULE_PARAMETER, slot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 0, 0.0 };
+            disabled.timestamp = AIOEvent::now();
+            changed.push_back(disabled);
+            return;
+        }
+
+        poweredOffSlots[slot] = false;
+        if (false == disableFailedSlots[slot])
+        {
+            disableFailedSlots[slot] = true;
+            AIOEvent failed { AIO_EVENT_MODULE_PARAMETER, slot, AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 1, 0.0 };
+            failed.timestamp = AIOEvent::now();
+            changed.push_back(failed);
+        }
+    }
+
+    const AIOApi& api;
+    const AIOOverCurrentPolicy policy;
+    AIOEventDispatcher events;
+    bool trippedSlots[AIO_numModuleSlots] {};           // monitor thread only
+    bool poweredOffSlots[AIO_numModuleSlots] {};        // supply turned off since the condition was last set
+    bool disableFailedSlots[AIO_numModuleSlots] {};     // failure already reported
+
+    std::mutex stopLock;
+    std::condition_variable wake;
+    std::chrono::milliseconds pollInterval {};
+    bool stopping = false;
+    std::thread monitorThread;
+};
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    AIOSession - reference-counted library lifetime
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include "AIOApi.h"
+
+/*
+    AIOSession
+
+    A handle to the shared, initialized library. The first open loads the library, resolves the AIOApi table,
+    and calls AIO_initialize; later opens only increment a count. The library is shut down and unloaded when
+    the last handle closes, so one component closing its session does not affect the others.
+
+    Copying a session opens another handle; moving transfers it. Destroying a session closes it.
+
+    The count is shared by everything built into one executable or library module. Plugins that are separate
+    DLLs or shared libraries should obtain their sessions through one common module so they share the count.
+*/
+class AIOSession
+{
+public:
+    AIOSession() = default;
+
+    ~AIOSession()
+    {
+        close();
+    }
+
+    AIOSession(const AIOSession& other)
+    {
+        if (other.isOpen())
+        {
+            std::lock_guard<std::mutex> guard(state().lock);
+            ++state().openCount;
+            table = other.table;
+        }
+    }
+
+    AIOSession(AIOSession&& other) noexcept :
+        table(other.table)
+    {
+        other.table = nullptr;
+    }
+
+    AIOSession& operator=(AIOSession other) noexcept
+    {
+        std::swap(table, other.table);
+        return *this;
+    }
+
+    /*
+        open
+
+        Parameters
+            path            Library path; ignored if a session is already open
+            error           Receives a description of the problem if the library could not be opened
+
+        Returns a session; check isOpen before use
+    */
+    static AIOSession open(const char* path, std::string& error)
+    {
+        auto& shared = state();
+        std::lock_guard<std::mutex> guard(shared.lock);
+
+        if (0 == shared.openCount)
+        {
+            shared.handle = AIOApi::openLibrary(path);
+            if (nullptr == shared.handle)
+            {
+                error = std::string("Unable to load Echo AIO library ") + path;
+                return {};
+            }
+
+            if (false == shared.api.resolve(shared.handle, error))
+            {
+                AIOApi::closeLibrary(shared.handle);
+                shared.handle = nullptr;
+                return {};
+            }
+
+            shared.api.AIO_initialize();
+        }
+
+        ++shared.openCount;
+
+        AIOSession session;
+        session.table = &shared.api;
+        return session;
+    }
+
+    static AIOSession open(std::string& error)
+    {
+        return open(AIOApi::defaultLibraryName, error);
+    }
+
+    /*
+        close
+
+        Releases this handle; the last handle to close calls AIO_shutdown and unloads the library
+    */
+    void close()
+    {
+        if (nullptr == table)
+        {
+            return;
+        }
+
+        table = nullptr;
+
+        auto& shared = state();
+        std::lock_guard<std::mutex> guard(shared.lock);
+        if (0 == --shared.openCount)
+        {
+            shared.api.AIO_shutdown();
+            AIOApi::closeLibrary(shared.handle);
+            shared.handle = nullptr;
+            shared.api = AIOApi {};
+        }
+    }
+
+    bool isOpen() const
+    {
+        return nullptr != table;
+    }
+
+    /*
+        api
+
+        The resolved library table; valid while this session is open
+    */
+    const AIOApi& api() const
+    {
+        return *table;
+    }
+
+    /*
+        getOpenCount
+
+        Returns the number of open session handles
+    */
+    static int getOpenCount()
+    {
+        std::lock_guard<std::mutex> guard(state().lock);
+        return state().openCount;
+    }
+
+private:
+    struct SharedState
+    {
+        std::mutex lock;
+        int openCount = 0;
+        AIOLibraryHandle handle = nullptr;
+        AIOApi api;
+    };
+
+    static SharedState& state()
+    {
+        static SharedState shared;
+        return shared;
+    }
+
+    const AIOApi* table = nullptr;
+};
@@ -0,0 +1,431 @@
+/*
+  ==============================================================================
+
+    AIOStateSnapshot - control state readable from a real-time audio thread
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "AIOApi.h"
+#include "AIOControlState.h"
+#include "AIOEvents.h"
+#include "AIONotification.h"
+
+/*
+    AIOStateSnapshot
+
+    Keeps an AIOControlState copy of every channel control and module parameter. getStateSnapshot copies it
+    without locking, allocating, or making a system call, so an audio callback can read the input gains, CCP
+    states, and output limits it needs. There are two copies, each in an AIOSeqlock: a write goes to the copy
+    readers are not using and then makes it current, so a reader never waits for a writer that was preempted
+    part way through a write.
+
+    start reads the whole state from the device and starts a refresh thread. The thread reads it again each
+    time the library broadcasts AIO_notificationString (on Windows and macOS), when refresh is called, and
+    every refreshMilliseconds; the periodic refresh also picks up the live values (AUX IN, measured voltage and
+    current, over current condition). Setters called through this object update the copy as soon as they
+    succeed.
+
+    registerChangeCallback reports each control that changed, with its new value, found by comparing each
+    refresh with the copy; pass the changes through an AIOEventCoalescer to merge bursts. Changes made through
+    the setters are reported too. Callbacks run on the refresh thread or on a setter's calling thread, one at a
+    time, in the order the changes were made.
+
+    Only the refresh thread and the setters write the copy, one at a time; any number of threads may read it.
+*/
+class AIOStateSnapshot
+{
+public:
+    explicit AIOStateSnapshot(const AIOApi& api_) :
+        api(api_)
+    {
+    }
+
+    ~AIOStateSnapshot()
+    {
+        stop();
+    }
+
+    AIOStateSnapshot(const AIOStateSnapshot&) = delete;
+    AIOStateSnapshot& operator=(const AIOStateSnapshot&) = delete;
+
+    /*
+        start
+
+        Parameters
+            refreshMilliseconds     Time between periodic refreshes; 0 refreshes only on a broadcast or refresh call
+            minimumMilliseconds     Shortest time between two refreshes. A broadcast or refresh call that comes
+                                    sooner is held until then, and any others that arrive meanwhile share the same
+                                    read, so a storm of broadcasts costs one read per interval.
+
+        Reads the state from the device before returning; call after AIO_initialize
+
+        Returns false if already started
+    */
+    bool start(int refreshMilliseconds = 250, int minimumMilliseconds = 0)
+    {
+        if (refreshThread.joinable())
+        {
+            return false;
+        }
+
+        refreshInterval = std::chrono::milliseconds(refreshMilliseconds);
+        minimumInterval = std::chrono::milliseconds(minimumMilliseconds);
+        stopping = false;
+        refreshRequested = false;
+        update();
+        started.store(true, std::memory_order_release);
+
+        refreshThread = std::thread(&AIOStateSnapshot::run, this);
+        listener.start(&AIOStateSnapshot::onNotification, this);
+        return true;
+    }
+
+    void stop()
+    {
+        listener.stop();
+        {
+            std::lock_guard<std::mutex> guard(refreshLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (refreshThread.joinable())
+        {
+            refreshThread.join();
+        }
+    }
+
+    /*
+        getStateSnapshot
+
+        Parameters
+            snapshot    Receives the most recently published state
+
+        Never locks, allocates, or makes a system call. Retries only if two writes completed while it was
+        copying.
+
+        Returns 0 if successful, ECHO_AIO_INVALID_PARAMETER for a null snapshot, or ECHO_AIO_NOT_INITIALIZED
+        before start
+    */
+    int getStateSnapshot(AIOControlState* const snapshot) const
+    {
+        if (nullptr == snapshot)
+        {
+            return ECHO_AIO_INVALID_PARAMETER;
+        }
+        if (false == started.load(std::memory_order_acquire))
+        {
+            return ECHO_AIO_NOT_INITIALIZED;
+        }
+
+        while (false == published[current.load(std::memory_order_acquire)].tryRead(*snapshot))
+        {
+        }
+        return ECHO_AIO_OK;
+    }
+
+    /*
+        refresh
+
+        Asks the refresh thread to read the state again; returns at once
+    */
+    void refresh()
+    {
+        {
+            std::lock_guard<std::mutex> guard(refreshLock);
+            refreshRequested = true;
+        }
+        wake.notify_one();
+    }
+
+    static void onNotification(void* context)
+    {
+        static_cast<AIOStateSnapshot*>(context)->refresh();
+    }
+
+    /*
+        registerChangeCallback
+
+        Parameters
+            callback        Called once for each changed control whose AIOEventType is in mask
+            mask            AIOEventType bits, e.g. AIO_EVENT_INPUT_GAIN | AIO_EVENT_OUTPUT_LIMIT
+            context         Passed to callback
+
+        Returns a registration number for unregisterChangeCallback, or 0 if callback is null
+    */
+    int registerChangeCallback(AIOEventDispatcher::Callback callback, int mask, void* context)
+    {
+        return events.registerCallback(callback, mask, context);
+    }
+
+    bool unregisterChangeCallback(int id)
+    {
+        return events.unregisterCallback(id);
+    }
+
+    //
+    // Setters; same parameters and return values as the library functions
+    //
+    int setInputGain(int inputChannel, int gain)
+    {
+        int status = api.AIO_setInputGain(inputChannel, gain);
+        if (ECHO_AIO_OK == status && isChannel(inputChannel))
+        {
+            change([&](AIOControlState& next, SetterFields& fields)
+                {
+                    next.inputGain[inputChannel] = gain;
+                    fields.inputGain[inputChannel] = true;
+                });
+        }
+        return status;
+    }
+
+    int setConstantCurrentState(int inputChannel, int enabled)
+    {
+        int status = api.AIO_setConstantCurrentState(inputChannel, enabled);
+        if (ECHO_AIO_OK == status && isChannel(inputChannel))
+        {
+            change([&](AIOControlState& next, SetterFields& fields)
+                {
+                    next.constantCurrent[inputChannel] = enabled;
+                    fields.constantCurrent[inputChannel] = true;
+                });
+        }
+        return status;
+    }
+
+    int setOutputLimitVolts(int outputChannel, double limitVolts)
+    {
+        int status = api.AIO_setOutputLimitVolts(outputChannel, limitVolts);
+        if (ECHO_AIO_OK == status && isChannel(outputChannel))
+        {
+            change([&](AIOControlState& next, SetterFields& fields)
+                {
+                    next.outputLimitVolts[outputChannel] = limitVolts;
+                    fields.outputLimitVolts[outputChannel] = true;
+                });
+        }
+        return status;
+    }
+
+    int setModuleIntParameter(int moduleSlot, int parameter, int value)
+    {
+        int status = api.AIO_setModuleIntParameter(moduleSlot, parameter, value);
+        int index = AIOControlState::getParameterIndex(parameter);
+        if (ECHO_AIO_OK == status && isSlot(moduleSlot) && index >= 0)
+        {
+            change([&](AIOControlState& next, SetterFields& fields)
+                {
+                    next.modules[moduleSlot].intParameters[index] = value;
+                    fields.intParameters[moduleSlot][index] = true;
+                });
+        }
+        return status;
+    }
+
+    int setModuleDoubleParameter(int moduleSlot, int parameter, double value)
+    {
+        int status = api.AIO_setModuleDoubleParameter(moduleSlot, parameter, value);
+        int index = AIOControlState::getParameterIndex(parameter);
+        if (ECHO_AIO_OK == status && isSlot(moduleSlot) && index >= 0)
+        {
+            change([&](AIOControlState& next, SetterFields& fields)
+                {
+                    next.modules[moduleSlot].doubleParameters[index] = value;
+                    fields.doubleParameters[moduleSlot][index] = true;
+                });
+        }
+        return status;
+    }
+
+private:
+    //
+    // Fields a setter wrote since the current read of the device started
+    //
+    struct SetterFields
+    {
+        bool inputGain[AIO_MAX_CHANNELS];
+        bool constantCurrent[AIO_MAX_CHANNELS];
+        bool outputLimitVolts[AIO_MAX_CHANNELS];
+        bool intParameters[AIO_numModuleSlots][AIO_MAX_MODULE_PARAMETERS];
+        bool doubleParameters[AIO_numModuleSlots][AIO_MAX_MODULE_PARAMETERS];
+    };
+
+    static bool isChannel(int channel)
+    {
+        return channel >= 0 && channel < AIO_MAX_CHANNELS;
+    }
+
+    static bool isSlot(int moduleSlot)
+    {
+        return moduleSlot >= 0 && moduleSlot < AIO_numModuleSlots;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> guard(refreshLock);
+        while (false == stopping)
+        {
+            auto requested = [this]() { return stopping || refreshRequested; };
+            if (refreshInterval.count())
+            {
+                wake.wait_for(guard, refreshInterval, requested);
+            }
+            else
+            {
+                wake.wait(guard, requested);
+            }
+            if (stopping)
+            {
+                break;
+            }
+
+            auto earliest = lastRefresh + minimumInterval;
+            if (minimumInterval.count() && std::chrono::steady_clock::now() < earliest)
+            {
+                wake.wait_until(guard, earliest, [this]() { return stopping; });
+                if (stopping)
+                {
+                    break;
+                }
+            }
+
+            refreshRequested = false;
+            lastRefresh = std::chrono::steady_clock::now();
+            guard.unlock();
+            update();
+            guard.lock();
+        }
+    }
+
+    //
+    // Reads the state from the device without holding the writer lock. A field a setter wrote meanwhile may
+    // have been read before the write reached the device, so the setter's value is kept for that field and the
+    // rest of the read is published.
+    //
+    void update()
+    {
+        {
+            std::lock_guard<std::mutex> guard(writerLock);
+            setterFields = SetterFields {};
+        }
+
+        AIOControlState fresh = AIOControlState::query(api);
+
+        {
+            std::lock_guard<std::mutex> guard(writerLock);
+            keepSetterFields(fresh);
+            fresh.updateCount = state.updateCount + 1;
+            replace(fresh);
+        }
+        events.drain();
+    }
+
+    //
+    // Called with writerLock held; copies each field in setterFields from the writer's copy into fresh
+    //
+    void keepSetterFields(AIOControlState& fresh) const
+    {
+        for (int channel = 0; channel < AIO_MAX_CHANNELS; ++channel)
+        {
+            if (setterFields.inputGain[channel])
+            {
+                fresh.inputGain[channel] = state.inputGain[channel];
+            }
+            if (setterFields.constantCurrent[channel])
+            {
+                fresh.constantCurrent[channel] = state.constantCurrent[channel];
+            }
+            if (setterFields.outputLimitVolts[channel])
+            {
+                fresh.outputLimitVolts[channel] = state.outputLimitVolts[channel];
+            }
+        }
+
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            for (int index = 0; index < AIO_MAX_MODULE_PARAMETERS; ++index)
+            {
+                if (setterFields.intParameters[slot][index])
+                {
+                    fresh.modules[slot].intParameters[index] = state.modules[slot].intParameters[index];
+                }
+                if (setterFields.doubleParameters[slot][index])
+                {
+                    fresh.modules[slot].doubleParameters[index] = state.modules[slot].doubleParameters[index];
+                }
+            }
+        }
+    }
+
+    template <typename Change>
+    void change(Change apply)
+    {
+        {
+            std::lock_guard<std::mutex> guard(writerLock);
+            AIOControlState next = state;
+            apply(next, setterFields);
+            ++next.updateCount;
+            replace(next);
+        }
+        events.drain();
+    }
+
+    //
+    // Called with writerLock held; posts the differences, which the caller delivers once it has released the lock
+    //
+    void replace(const AIOControlState& next)
+    {
+        std::vector<AIOEvent> changed;
+        if (started.load(std::memory_order_relaxed) && events.getMask())
+        {
+            AIOStateChanges::find(state, next, changed);
+            int64_t timestamp = AIOEvent::now();
+            for (auto& event : changed)
+            {
+                event.timestamp = timestamp;
+            }
+        }
+
+        state = next;
+        int copy = 1 - current.load(std::memory_order_relaxed);
+        published[copy].write(state);
+        current.store(copy, std::memory_order_release);
+
+        if (false == changed.empty())
+        {
+            events.post(changed);
+        }
+    }
+
+    const AIOApi& api;
+    AIOSeqlock<AIOControlState> published[2];
+    std::atomic<int> current { 0 };     // copy readers use
+    std::atomic<bool> started { false };
+
+    std::mutex writerLock;          // one writer of published at a time
+    AIOControlState state {};       // writer's copy
+    SetterFields setterFields {};   // guarded by writerLock
+
+    AIOEventDispatcher events;
+
+    std::mutex refreshLock;
+    std::condition_variable wake;
+    std::chrono::milliseconds refreshInterval {};
+    std::chrono::milliseconds minimumInterval {};
+    std::chrono::steady_clock::time_point lastRefresh;
+    bool refreshRequested = false;
+    bool stopping = false;
+    std::thread refreshThread;
+    AIONotificationListener listener;
+};
@@ -0,0 +1,388 @@
+/*
+  ==============================================================================
+
+    AIOTopology - warm-start snapshot of the AIO channel and module layout
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AIOApi.h"
+
+enum AIOModuleType
+{
+    AIO_MODULE_NONE = 0,
+    AIO_MODULE_COMBO,
+    AIO_MODULE_T
+};
+
+struct AIOModuleTopology
+{
+    int type = AIO_MODULE_NONE;
+    int firmwareVersion = -1;
+    int serialNumber = -1;      // AIO-C modules only
+
+    bool operator==(const AIOModuleTopology& other) const
+    {
+        return type == other.type && firmwareVersion == other.firmwareVersion && serialNumber == other.serialNumber;
+    }
+};
+
+/*
+    AIOTopology
+
+    Everything the library reports about the layout of a connected AIO: channel counts, the module in each slot
+    with its firmware version and serial number, and the TEDS properties of each input channel (empty if the
+    channel has no TEDS).
+
+    query reads all of it from the device. save and load keep a snapshot in a text file so the next run can
+    skip the full query; validate confirms the snapshot still matches with one identity read per occupied
+    module slot. The key string names the unit by its channel counts, module types, and module serial numbers.
+
+    TEDS content is not re-validated. load calls AIO_hasTEDS on every input channel and reads the TEDS again
+    only where a sensor has been connected or disconnected since the snapshot was saved; a sensor swapped for
+    another that also has TEDS keeps the saved properties until the topology is queried again.
+
+    AIO-T modules report no serial number, so an AIO-T module swapped for another with the same firmware
+    version passes validation. The snapshot still describes the replacement correctly, since it records only
+    the type and firmware version of an AIO-T module.
+*/
+struct AIOTopology
+{
+    int numInputChannels = 0;
+    int numOutputChannels = 0;
+    AIOModuleTopology modules[AIO_numModuleSlots];
+    std::vector<std::string> teds;
+
+    /*
+        query
+
+        Reads the full topology; call after AIO_initialize
+    */
+    static AIOTopology query(const AIOApi& api)
+    {
+        AIOTopology topology;
+        topology.numInputChannels = api.AIO_getNumInputChannels();
+        topology.numOutputChannels = api.AIO_getNumOutputChannels();
+
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            topology.modules[slot] = queryModule(api, slot);
+        }
+
+        topology.teds.resize(topology.numInputChannels);
+        for (int channel = 0; channel < topology.numInputChannels; ++channel)
+        {
+            topology.teds[channel] = queryTEDS(api, channel);
+        }
+
+        return topology;
+    }
+
+    static AIOModuleTopology queryModule(const AIOApi& api, int slot)
+    {
+        AIOModuleTopology module;
+        if (api.AIO_hasComboModule(slot))
+        {
+            module.type = AIO_MODULE_COMBO;
+            api.AIO_getModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_FIRMWARE_VERSION, &module.firmwareVersion);
+            api.AIO_getModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_SERIAL_NUMBER, &module.serialNumber);
+        }
+        else if (api.AIO_hasTModule(slot))
+        {
+            module.type = AIO_MODULE_T;
+            api.AIO_getModuleIntParameter(slot, AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION, &module.firmwareVersion);
+        }
+        return module;
+    }
+
+    static int queryModuleType(const AIOApi& api, int slot)
+    {
+        if (api.AIO_hasComboModule(slot))
+        {
+            return AIO_MODULE_COMBO;
+        }
+        return api.AIO_hasTModule(slot) ? AIO_MODULE_T : AIO_MODULE_NONE;
+    }
+
+    static std::string queryTEDS(const AIOApi& api, int channel)
+    {
+        if (false == api.AIO_hasTEDS(channel))
+        {
+            return {};
+        }
+
+        size_t bytesRequired = 0;
+        if (ECHO_AIO_OK != api.AIO_getTEDSProperties(channel, nullptr, 0, &bytesRequired) || 0 == bytesRequired)
+        {
+            return {};
+        }
+
+        std::vector<char> json(bytesRequired);
+        if (ECHO_AIO_OK != api.AIO_getTEDSProperties(channel, json.data(), json.size(), &bytesRequired))
+        {
+            return {};
+        }
+        return json.data();
+    }
+
+    /*
+        validate
+
+        Compares the input and output channel counts and the module type in each slot with the connected
+        unit, then reads the serial number (AIO-C) or firmware version (AIO-T) of each occupied slot and
+        compares it with the saved value. Every part of the key is checked.
+
+        Returns true if the snapshot still describes the connected AIO
+    */
+    bool validate(const AIOApi& api) const
+    {
+        if (0 == numInputChannels && 0 == numOutputChannels)
+        {
+            return false;
+        }
+
+        if (api.AIO_getNumInputChannels() != numInputChannels || api.AIO_getNumOutputChannels() != numOutputChannels)
+        {
+            return false;
+        }
+
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            const AIOModuleTopology& module = modules[slot];
+            if (queryModuleType(api, slot) != module.type)
+            {
+                return false;
+            }
+
+            int value = -1;
+            switch (module.type)
+            {
+            case AIO_MODULE_COMBO:
+                if (ECHO_AIO_OK != api.AIO_getModuleIntParameter(slot, AIO_COMBO_MODULE_PARAMETER_SERIAL_NUMBER, &value) ||
+                    value != module.serialNumber)
+                {
+                    return false;
+                }
+                break;
+
+            case AIO_MODULE_T:
+                if (ECHO_AIO_OK != api.AIO_getModuleIntParameter(slot, AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION, &value) ||
+                    value != module.firmwareVersion)
+                {
+                    return false;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    std::string key() const
+    {
+        std::ostringstream stream;
+        stream << "in" << numInputChannels << "-out" << numOutputChannels;
+        for (const auto& module : modules)
+        {
+            stream << "-" << module.type << ":" << module.serialNumber;
+        }
+        return stream.str();
+    }
+
+    /*
+        updateTEDSPresence
+
+        Reads the TEDS again on each input channel where AIO_hasTEDS no longer agrees with the snapshot
+    */
+    void updateTEDSPresence(const AIOApi& api)
+    {
+        for (size_t channel = 0; channel < teds.size(); ++channel)
+        {
+            bool present = 0 != api.AIO_hasTEDS(static_cast<int>(channel));
+            if (present != (false == teds[channel].empty()))
+            {
+                teds[channel] = queryTEDS(api, static_cast<int>(channel));
+            }
+        }
+    }
+
+    /*
+        save
+        load
+
+        Snapshot file format, one record per line:
+            EchoAIOTopology 2 <key>
+            channels <inputs> <outputs>
+            module <slot> <type> <firmware version> <serial number>
+            teds <channel> <JSON text, with backslash, line feed, and carriage return escaped as \\, \n, and \r>
+
+        load checks that the stored key matches the records that follow it, then validates the snapshot
+        against the connected unit, so a file saved on another unit is rejected. It then calls
+        updateTEDSPresence.
+
+        Returns true if successful
+    */
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "EchoAIOTopology 2 " << key() << "\n";
+        file << "channels " << numInputChannels << " " << numOutputChannels << "\n";
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+        {
+            file << "module " << slot << " " << modules[slot].type << " " << modules[slot].firmwareVersion << " " << modules[slot].serialNumber << "\n";
+        }
+        for (size_t channel = 0; channel < teds.size(); ++channel)
+        {
+            if (teds[channel].size())
+            {
+                file << "teds " << channel << " " << escapeLine(teds[channel]) << "\n";
+            }
+        }
+        return file.good();
+    }
+
+    bool load(const std::string& path, const AIOApi& api)
+    {
+        static const std::string header = "EchoAIOTopology 2 ";
+        std::ifstream file(path);
+        std::string line;
+        if (std::getline(file, line).fail() || 0 != line.rfind(header, 0))
+        {
+            return false;
+        }
+        std::string storedKey = line.substr(header.size());
+
+        AIOTopology topology;
+        while (std::getline(file, line))
+        {
+            std::istringstream record(line);
+            std::string tag;
+            record >> tag;
+            if ("channels" == tag)
+            {
+                record >> topology.numInputChannels >> topology.numOutputChannels;
+                topology.teds.assign(topology.numInputChannels > 0 ? topology.numInputChannels : 0, {});
+            }
+            else if ("module" == tag)
+            {
+                int slot = -1;
+                AIOModuleTopology module;
+                record >> slot >> module.type >> module.firmwareVersion >> module.serialNumber;
+                if (slot < 0 || slot >= AIO_numModuleSlots)
+                {
+                    return false;
+                }
+                topology.modules[slot] = module;
+            }
+            else if ("teds" == tag)
+            {
+                size_t channel = 0;
+                record >> channel;
+                record.get();
+                if (channel >= topology.teds.size())
+                {
+                    return false;
+                }
+                std::string text;
+                std::getline(record, text);
+                topology.teds[channel] = unescapeLine(text);
+            }
+
+            if (record.fail())
+            {
+                return false;
+            }
+        }
+
+        if (storedKey != topology.key() || false == topology.validate(api))
+        {
+            return false;
+        }
+
+        topology.updateTEDSPresence(api);
+        *this = topology;
+        return true;
+    }
+
+    //
+    // Keeps each TEDS record on one line of the snapshot file
+    //
+    static std::string escapeLine(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '\\':
+                escaped += "\\\\";
+                break;
+
+            case '\n':
+                escaped += "\\n";
+                break;
+
+            case '\r':
+                escaped += "\\r";
+                break;
+
+            default:
+                escaped += c;
+                break;
+            }
+        }
+        return escaped;
+    }
+
+    static std::string unescapeLine(const std::string& line)
+    {
+        std::string text;
+        for (size_t index = 0; index < line.size(); ++index)
+        {
+            char c = line[index];
+            if ('\\' == c && index + 1 < line.size())
+            {
+                c = line[++index];
+                c = 'n' == c ? '\n' : 'r' == c ? '\r' : c;
+            }
+            text += c;
+        }
+        return text;
+    }
+
+    /*
+        loadOrQuery
+
+        Parameters
+            api             Resolved library table; call after AIO_initialize
+            path            Snapshot file
+            warmStart       Set to true if the snapshot was valid and the full query was skipped
+
+        Uses the snapshot at path if it loads and validates; otherwise queries the device and saves a new snapshot.
+        A warm start re-reads the TEDS only of channels whose sensor was connected or disconnected.
+    */
+    static AIOTopology loadOrQuery(const AIOApi& api, const std::string& path, bool& warmStart)
+    {
+        AIOTopology topology;
+        warmStart = topology.load(path, api);
+        if (warmStart)
+        {
+            return topology;
+        }
+
+        topology = query(api);
+        topology.save(path);
+        return topology;
+    }
+};
@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    AIOTrace - timeline of library calls in Chrome / Perfetto trace format
+
+    Copyright (c) 2022 - Echo Digital Audio Corporation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AIOApi.h"
+
+#if _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+struct AIOTraceEvent
+{
+    int32_t function;       // AIOFunction
+    int32_t status;         // ECHO_AIO_* code, or 0 for functions that do not return one
+    int32_t threadId;       // small number assigned to each calling thread
+    int64_t startNanoseconds;
+    int64_t endNanoseconds;
+};
+
+/*
+    AIOTrace
+
+    Opt-in recording of calls made through a table returned by AIOInstrumentation::instrument. While a trace
+    is open, each call that sends a USB command (or every call, if requested) is recorded with its function,
+    thread, start and end times, and status.
+
+    Each calling thread owns a fixed-size ring of events and adds to it without locking; if the ring is full
+    the event is dropped and counted. flush drains every ring into the trace file, so a long run should call
+    flush from time to time (for example, from a UI timer). close flushes and finishes the file, which can then
+    be opened in chrome://tracing or https://ui.perfetto.dev.
+
+    Ring capacity is fixed when a thread first records; later opens reuse it.
+*/
+class AIOTrace
+{
+public:
+    /*
+        open
+
+        Parameters
+            path                Trace file to create
+            eventsPerThread     Capacity of each thread's ring
+            allCalls            false to record only calls that send a USB command; true to record every call
+
+        Returns true if the file was created and recording started
+    */
+    static bool open(const char* path, size_t eventsPerThread = 65536, bool allCalls = false)
+    {
+        Shared& shared = getShared();
+        std::lock_guard<std::mutex> guard(shared.readerLock);
+        closeFile(shared);
+
+        shared.file = std::fopen(path, "w");
+        if (nullptr == shared.file)
+        {
+            return false;
+        }
+
+        std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", shared.file);
+        shared.firstEvent = true;
+        shared.capacity = std::max<size_t>(eventsPerThread, 1);
+        shared.origin = getNanoseconds();
+        shared.allCalls.store(allCalls, std::memory_order_relaxed);
+
+        //
+        // Discard anything recorded since the previous trace closed
+        //
+        for (ThreadEvents* block = shared.head.load(std::memory_order_acquire); block; block = block->next)
+        {
+            block->tail.store(block->head.load(std::memory_order_acquire), std::memory_order_release);
+            block->dropped.store(0, std::memory_order_relaxed);
+        }
+
+        shared.enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    /*
+        flush
+
+        Writes every recorded event to the trace file
+
+        Returns the number of events dropped because a ring was full since the trace was opened
+    */
+    static uint64_t flush()
+    {
+        Shared& shared = getShared();
+        std::lock_guard<std::mutex> guard(shared.readerLock);
+        return drain(shared);
+    }
+
+    /*
+        close
+
+        Stops recording, flushes, and finishes the trace file
+
+        Returns the number of events dropped because a ring was full
+    */
+    static uint64_t close()
+    {
+        Shared& shared = getShared();
+        std::lock_guard<std::mutex> guard(shared.readerLock);
+        shared.enabled.store(false, std::memory_order_release);
+        uint64_t dropped = drain(shared);
+        closeFile(shared);
+        return dropped;
+    }
+
+    static bool isEnabled()
+    {
+        return getShared().enabled.load(std::memory_order_relaxed);
+    }
+
+    /*
+        record
+
+        Called by AIOInstrumentation for each call while a trace is open
+    */
+    static void record(int function, int status, bool sendsCommand, std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end)
+    {
+        Shared& shared = getShared();
+        if (false == sendsCommand && false == shared.allCalls.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        ThreadEvents* block = getThreadEvents(shared);
+
+        uint64_t head = block->head.load(std::memory_order_relaxed);
+        if (head - block->tail.load(std::memory_order_acquire) >= block->events.size())
+        {
+            block->dropped.store(block->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        AIOTraceEvent& event = block->events[head % block->events.size()];
+        event.function = function;
+        event.status = status;
+        event.threadId = block->threadId;
+        event.startNanoseconds = toNanoseconds(start);
+        event.endNanoseconds = toNanoseconds(end);
+        block->head.store(head + 1, std::memory_order_release);
+    }
+
+private:
+    struct ThreadEvents
+    {
+        std::atomic<bool> inUse { true };
+        int32_t threadId = 0;
+        ThreadEvents* next = nullptr;
+        std::vector<AIOTraceEvent> events;
+        std::atomic<uint64_t> head { 0 };       // written by the owning thread
+        std::atomic<uint64_t> tail { 0 };       // written by the reader
+        std::atomic<uint64_t> dropped { 0 };
+    };
+
+    struct ThreadEventsOwner
+    {
+        ThreadEvents* events = nullptr;
+
+        ~ThreadEventsOwner()
+        {
+            if (events)
+            {
+                events->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    struct Shared
+    {
+        std::atomic<bool> enabled { false };
+        std::atomic<bool> allCalls { false };
+        std::atomic<ThreadEvents*> head { nullptr };
+        std::atomic<int32_t> nextThreadId { 1 };
+        std::mutex readerLock;
+        std::FILE* file = nullptr;
+        bool firstEvent = true;
+        size_t capacity = 65536;
+        int64_t origin = 0;
+    };
+
+    static int64_t toNanoseconds(std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    static int64_t getNanoseconds()
+    {
+        return toNanoseconds(std::chrono::steady_clock::now());
+    }
+
+    static ThreadEvents* getThreadEvents(Shared& shared)
+    {
+        thread_local ThreadEventsOwner owner;
+        if (owner.events)
+        {
+            return owner.events;
+        }
+
+        ThreadEvents* block = nullptr;
+        for (ThreadEvents* candidate = shared.head.load(std::memory_order_acquire); candidate; candidate = candidate->next)
+        {
+            bool expected = false;
+            if (candidate->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                block = candidate;
+                break;
+            }
+        }
+
+        if (nullptr == block)
+        {
+            block = new ThreadEvents;
+            {
+                std::lock_guard<std::mutex> guard(shared.readerLock);
+                block->events.resize(shared.capacity);
+            }
+            block->next = shared.head.load(std::memory_order_relaxed);
+            while (false == shared.head.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        block->threadId = shared.nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        owner.events = block;
+        return block;
+    }
+
+    static uint64_t drain(Shared& shared)
+    {
+        uint64_t dropped = 0;
+        for (ThreadEvents* block = shared.head.load(std::memory_order_acquire); block; block = block->next)
+        {
+            uint64_t tail = block->tail.load(std::memory_order_relaxed);
+            uint64_t head = block->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail)
+            {
+                writeEvent(shared, block->events[tail % block->events.size()]);
+            }
+            block->tail.store(tail, std::memory_order_release);
+            dropped += block->dropped.load(std::memory_order_relaxed);
+        }
+
+        if (shared.file)
+        {
+            std::fflush(shared.file);
+        }
+        return dropped;
+    }
+
+    static void writeEvent(Shared& shared, const AIOTraceEvent& event)
+    {
+        if (nullptr == shared.file)
+        {
+            return;
+        }
+
+#if _WIN32
+        int processId = _getpid();
+#else
+        int processId = static_cast<int>(getpid());
+#endif
+
+        //
+        // Complete ("X") events; Chrome trace timestamps are in microseconds
+        //
+        std::fprintf(shared.file, "%s{\"name\":\"%s\",\"cat\":\"aio\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"status\":%d}}",
+            shared.firstEvent ? "" : ",\n",
+            getAIOFunctionName(event.function),
+            (event.startNanoseconds - shared.origin) / 1000.0,
+            (event.endNanoseconds - event.startNanoseconds) / 1000.0,
+            processId,
+            static_cast<int>(event.threadId),
+            static_cast<int>(event.status));
+        shared.firstEvent = false;
+    }
+
+    static void closeFile(Shared& shared)
+    {
+        if (shared.file)
+        {
+            std::fputs("\n]}\n", shared.file);
+            std::fclose(shared.file);
+            shared.file = nullptr;
+        }
+    }
+
+    static Shared& getShared()
+    {
+        static Shared shared;
+        return shared;
+    }
+};
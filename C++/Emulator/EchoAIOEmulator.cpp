@@ -0,0 +1,934 @@
+/*
+  ==============================================================================
+
+    EchoAIOEmulator - emulated AIO backend
+
+    Build as a shared library named like the real one, for example on Linux:
+
+        c++ -std=c++17 -O2 -shared -fPIC -DECHO_AIO_EXPORTS=1 \
+            C++/Emulator/EchoAIOEmulator.cpp -o EchoAIOInterface.so -lpthread
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EchoAIOEmulator.h"
+
+namespace
+{
+    enum class ModuleType
+    {
+        none,
+        combo,
+        tdm,
+        headphone,
+        bluetooth
+    };
+
+    struct InputChannel
+    {
+        int gain = 1;
+        int constantCurrent = 0;
+        std::string teds;
+    };
+
+    struct OutputChannel
+    {
+        int gain = 255;
+        double limitVolts = 5.0;
+    };
+
+    struct Module
+    {
+        ModuleType type = ModuleType::none;
+        std::map<int, int> intParameters;
+        std::map<int, double> doubleParameters;
+    };
+
+    struct Options
+    {
+        int discoveryMilliseconds = 1500;
+        int commandMicroseconds = 0;
+        int commandJitterMicroseconds = 0;
+        int tedsMicroseconds = -1;
+        int seed = 1;
+        int serialNumber = 100001;
+        int inputChannels = 4;
+        int outputChannels = 2;
+        int outputGainControl = 0;
+        int auxLoopback = 0;
+        int commandLanes = 0;
+        int connected = 1;
+        int shortCircuit = 0;
+        std::string modules = "CT";
+        std::map<int, std::string> teds;
+    };
+
+    struct IntegerOption
+    {
+        const char* name;
+        int Options::* value;
+        long minimum;
+        long maximum;
+    };
+
+    const IntegerOption integerOptions[] =
+    {
+        { "discoveryMilliseconds", &Options::discoveryMilliseconds, 0, 600000 },
+        { "commandMicroseconds", &Options::commandMicroseconds, 0, 10000000 },
+        { "commandJitterMicroseconds", &Options::commandJitterMicroseconds, 0, 10000000 },
+        { "tedsMicroseconds", &Options::tedsMicroseconds, -1, 10000000 },
+        { "seed", &Options::seed, 0, 0x7fffffff },
+        { "serialNumber", &Options::serialNumber, 0, 0x7fffffff },
+        { "inputChannels", &Options::inputChannels, 0, 32 },
+        { "outputChannels", &Options::outputChannels, 0, 32 },
+        { "outputGainControl", &Options::outputGainControl, 0, 1 },
+        { "auxLoopback", &Options::auxLoopback, 0, 1 },
+        { "commandLanes", &Options::commandLanes, 0, 2 },
+        { "connected", &Options::connected, 0, 1 },
+        { "shortCircuit", &Options::shortCircuit, 0, 1 }
+    };
+
+    const int maxTEDSChannels = 32;
+
+    //
+    // USB command lanes: input channels, output channels, then one per module slot
+    //
+    const int inputLane = 0;
+    const int outputLane = 1;
+    const int numLanes = 2 + AIO_numModuleSlots;
+
+    struct Emulator
+    {
+        std::mutex lock;
+        std::mutex lanes[numLanes];         // held for the length of an emulated USB command
+        Options options;
+        bool initialized = false;
+        std::vector<InputChannel> inputs;
+        std::vector<OutputChannel> outputs;
+        Module modules[AIO_numModuleSlots];
+        std::string lastError;
+        std::mt19937 random;
+#if _WIN32
+        int asioBufferSize = 256;
+        int sampleRate = 48000;
+#endif
+    };
+
+    //
+    // Options
+    //
+    int setOption(Options& options, const std::string& name, const std::string& value)
+    {
+        char* end = nullptr;
+        long number = std::strtol(value.c_str(), &end, 0);
+        bool isNumber = value.size() && 0 == *end;
+
+        for (const auto& option : integerOptions)
+        {
+            if (name != option.name)
+                continue;
+
+            if (false == isNumber || number < option.minimum || number > option.maximum)
+                return ECHO_AIO_INVALID_VALUE;
+
+            options.*option.value = static_cast<int>(number);
+            return ECHO_AIO_OK;
+        }
+
+        if ("modules" == name)
+        {
+            if (value.size() != AIO_numModuleSlots || std::string::npos != value.find_first_not_of("CTHB-"))
+                return ECHO_AIO_INVALID_VALUE;
+
+            options.modules = value;
+            return ECHO_AIO_OK;
+        }
+
+        if (0 == name.rfind("teds", 0))
+        {
+            std::string suffix = name.substr(4);
+            char* channelEnd = nullptr;
+            long channel = std::strtol(suffix.c_str(), &channelEnd, 10);
+            if (suffix.empty() || 0 != *channelEnd || channel < 0 || channel >= maxTEDSChannels)
+                return ECHO_AIO_INVALID_PARAMETER;
+
+            options.teds[static_cast<int>(channel)] = value;
+            return ECHO_AIO_OK;
+        }
+
+        return ECHO_AIO_INVALID_PARAMETER;
+    }
+
+    std::string getEnvironmentVariableName(const std::string& option)
+    {
+        std::string variable = "ECHO_AIO_EMULATOR_";
+        for (auto c : option)
+            variable += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        return variable;
+    }
+
+    void readEnvironment(Options& options)
+    {
+        std::vector<std::string> names { "modules" };
+        for (const auto& option : integerOptions)
+            names.push_back(option.name);
+        for (int channel = 0; channel < maxTEDSChannels; ++channel)
+            names.push_back("teds" + std::to_string(channel));
+
+        for (const auto& name : names)
+        {
+            if (auto value = std::getenv(getEnvironmentVariableName(name).c_str()))
+                setOption(options, name, value);
+        }
+    }
+
+    Emulator& emulator()
+    {
+        static Emulator instance;
+        static bool environmentRead = (readEnvironment(instance.options), true);
+        (void) environmentRead;
+        return instance;
+    }
+
+    //
+    // Emulated USB round trip: commandMicroseconds (or tedsMicroseconds for TEDS reads) plus a uniformly
+    // distributed jitter of up to commandJitterMicroseconds. Sleeps outside the device lock so callers on
+    // other threads (or other emulated units) are not held up; with commandLanes set, a command waits for
+    // earlier commands on its lane.
+    //
+    enum class Command
+    {
+        control,
+        teds
+    };
+
+    int slotLane(int moduleSlot)
+    {
+        return 2 + std::clamp(moduleSlot, 0, AIO_numModuleSlots - 1);
+    }
+
+    void transfer(Emulator& aio, int lane, Command command = Command::control)
+    {
+        int microseconds = 0;
+        int lanes = 0;
+        {
+            std::lock_guard<std::mutex> guard(aio.lock);
+            const Options& options = aio.options;
+            microseconds = Command::teds == command && options.tedsMicroseconds >= 0 ? options.tedsMicroseconds : options.commandMicroseconds;
+            if (options.commandJitterMicroseconds > 0)
+                microseconds += std::uniform_int_distribution<int>(0, options.commandJitterMicroseconds)(aio.random);
+            lanes = options.commandLanes;
+        }
+
+        if (microseconds <= 0)
+            return;
+
+        if (0 == lanes)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(aio.lanes[1 == lanes ? inputLane : lane]);
+        std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+    }
+
+    //
+    // Virtual device
+    //
+    const char* describe(int status)
+    {
+        switch (status)
+        {
+        case ECHO_AIO_OK: return "";
+        case ECHO_AIO_NOT_INITIALIZED: return "Library not initialized";
+        case ECHO_AIO_INVALID_INPUT_CHANNEL: return "Invalid input channel";
+        case ECHO_AIO_INVALID_OUTPUT_CHANNEL: return "Invalid output channel";
+        case ECHO_AIO_INVALID_PARAMETER: return "Invalid parameter";
+        case ECHO_AIO_INVALID_TEDS_SIZE: return "Invalid TEDS size";
+        case ECHO_AIO_NOT_FOUND: return "Not found";
+        case ECHO_AIO_USB_COMMAND_FAILED: return "USB command failed";
+        case ECHO_AIO_INVALID_MODULE_SLOT: return "Invalid module slot";
+        case ECHO_AIO_BUFFER_TOO_SMALL: return "Buffer too small";
+        case ECHO_AIO_NOT_SUPPORTED: return "Not supported";
+        case ECHO_AIO_TEDS_DEVICE_NOT_FOUND: return "TEDS device not found";
+        case ECHO_AIO_INVALID_VALUE: return "Invalid value";
+        case ECHO_AIO_TIMEOUT: return "Timed out";
+        }
+        return "Unknown error";
+    }
+
+    int fail(Emulator& aio, int status)
+    {
+        aio.lastError = describe(status);
+        return status;
+    }
+
+    void buildComboModule(Emulator& aio, Module& combo)
+    {
+        combo.intParameters =
+        {
+            { AIO_COMBO_MODULE_PARAMETER_FIRMWARE_VERSION, 0x0105 },
+            { AIO_COMBO_MODULE_PARAMETER_SERIAL_NUMBER, aio.options.serialNumber },
+            { AIO_COMBO_MODULE_PARAMETER_AUX_OUT, 0 },
+            { AIO_COMBO_MODULE_PARAMETER_AUX_IN, 0 },
+            { AIO_COMBO_MODULE_PARAMETER_5VDC_ENABLE, 0 },
+            { AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE, 0 },
+            { AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_TARGET_MILLIVOLTS, 3300 },
+            { AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_MILLIVOLTS, 0 },
+            { AIO_COMBO_MODULE_PARAMETER_MEASURED_CURRENT_RANGE, AIO_COMBO_MODULE_CURRENT_MEASUREMENT_250MA },
+            { AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION, 0 }
+        };
+        combo.doubleParameters =
+        {
+            { AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT, 0.0 },
+            { AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD, 0.2 }
+        };
+    }
+
+    void buildTModule(Module& tdm)
+    {
+        for (int parameter = AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION; parameter <= AIO_T_MODULE_PARAMETER_FSYNC_WIDTH; ++parameter)
+            tdm.intParameters[parameter] = 0;
+        tdm.intParameters[AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION] = 0x0210;
+    }
+
+    void buildModule(Emulator& aio, int slot)
+    {
+        Module& module = aio.modules[slot];
+        module = Module {};
+        switch (aio.options.modules[slot])
+        {
+        case 'C': module.type = ModuleType::combo; buildComboModule(aio, module); break;
+        case 'T': module.type = ModuleType::tdm; buildTModule(module); break;
+        case 'H': module.type = ModuleType::headphone; break;
+        case 'B': module.type = ModuleType::bluetooth; break;
+        default: break;
+        }
+    }
+
+    void buildDevice(Emulator& aio)
+    {
+        const Options& options = aio.options;
+
+        aio.inputs.assign(options.inputChannels, InputChannel {});
+        for (int channel = 0; channel < options.inputChannels; ++channel)
+        {
+            auto configured = options.teds.find(channel);
+            if (options.teds.end() != configured)
+            {
+                aio.inputs[channel].teds = configured->second;
+            }
+            else if (channel < 2)
+            {
+                aio.inputs[channel].teds = "{\"manufacturer\":\"Echo Emulated\",\"model\":\"EMU-IEPE\",\"serialNumber\":" +
+                    std::to_string(1000 + channel) + ",\"sensitivity\":0.05}";
+            }
+        }
+        aio.outputs.assign(options.outputChannels, OutputChannel {});
+
+        for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+            buildModule(aio, slot);
+
+        aio.random.seed(static_cast<unsigned>(options.seed));
+    }
+
+    bool isReadOnly(int parameter)
+    {
+        switch (parameter)
+        {
+        case AIO_COMBO_MODULE_PARAMETER_FIRMWARE_VERSION:
+        case AIO_COMBO_MODULE_PARAMETER_SERIAL_NUMBER:
+        case AIO_COMBO_MODULE_PARAMETER_AUX_IN:
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_MILLIVOLTS:
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT:
+        case AIO_T_MODULE_PARAMETER_FIRMWARE_VERSION:
+            return true;
+        }
+        return false;
+    }
+
+    double currentRangeAmps(int range)
+    {
+        static const double amps[] = { 256e-6, 1280e-6, 0.256, 1.28 };
+        return amps[std::clamp(range, 0, 3)];
+    }
+
+    int validateIntValue(const Module& module, int parameter, int value)
+    {
+        if (ModuleType::tdm == module.type)
+            return value >= 0 && value <= 255 ? ECHO_AIO_OK : ECHO_AIO_INVALID_VALUE;
+
+        switch (parameter)
+        {
+        case AIO_COMBO_MODULE_PARAMETER_AUX_OUT:
+            return value >= 0 && value <= 0xff ? ECHO_AIO_OK : ECHO_AIO_INVALID_VALUE;
+
+        case AIO_COMBO_MODULE_PARAMETER_5VDC_ENABLE:
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE:
+            return 0 == value || 1 == value ? ECHO_AIO_OK : ECHO_AIO_INVALID_VALUE;
+
+        case AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_TARGET_MILLIVOLTS:
+            return value >= 600 && value <= 5000 ? ECHO_AIO_OK : ECHO_AIO_INVALID_VALUE;
+
+        case AIO_COMBO_MODULE_PARAMETER_MEASURED_CURRENT_RANGE:
+            return value >= AIO_COMBO_MODULE_CURRENT_MEASUREMENT_250UA && value <= AIO_COMBO_MODULE_CURRENT_MEASUREMENT_1250MA ?
+                ECHO_AIO_OK : ECHO_AIO_INVALID_VALUE;
+
+        case AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION:
+            return 0 == value ? ECHO_AIO_OK : ECHO_AIO_INVALID_VALUE;
+        }
+        return ECHO_AIO_OK;
+    }
+
+    //
+    // A short circuit draws the full measurement range; the over current condition latches until it is cleared
+    //
+    void updateMeasurements(const Options& options, Module& module)
+    {
+        if (ModuleType::combo != module.type)
+            return;
+
+        bool enabled = module.intParameters[AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_ENABLE] != 0;
+        double amps = currentRangeAmps(module.intParameters[AIO_COMBO_MODULE_PARAMETER_MEASURED_CURRENT_RANGE]);
+        if (0 == options.shortCircuit)
+            amps /= 16.0;
+
+        module.intParameters[AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_MILLIVOLTS] =
+            enabled ? module.intParameters[AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_TARGET_MILLIVOLTS] : 0;
+        module.doubleParameters[AIO_COMBO_MODULE_PARAMETER_VARIABLE_DC_POWER_MEASURED_CURRENT] = enabled ? amps : 0.0;
+        if (enabled && amps > module.doubleParameters[AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_THRESHOLD])
+            module.intParameters[AIO_COMBO_MODULE_PARAMETER_OVER_CURRENT_CONDITION] = 1;
+    }
+
+    //
+    // Common argument checks; each returns ECHO_AIO_OK or the error to report
+    //
+    int checkInput(Emulator& aio, int inputChannel)
+    {
+        if (false == aio.initialized)
+            return ECHO_AIO_NOT_INITIALIZED;
+        if (0 == aio.options.connected)
+            return ECHO_AIO_USB_COMMAND_FAILED;
+        if (inputChannel < 0 || inputChannel >= static_cast<int>(aio.inputs.size()))
+            return ECHO_AIO_INVALID_INPUT_CHANNEL;
+        return ECHO_AIO_OK;
+    }
+
+    int checkOutput(Emulator& aio, int outputChannel)
+    {
+        if (false == aio.initialized)
+            return ECHO_AIO_NOT_INITIALIZED;
+        if (0 == aio.options.connected)
+            return ECHO_AIO_USB_COMMAND_FAILED;
+        if (outputChannel < 0 || outputChannel >= static_cast<int>(aio.outputs.size()))
+            return ECHO_AIO_INVALID_OUTPUT_CHANNEL;
+        return ECHO_AIO_OK;
+    }
+
+    int checkModule(Emulator& aio, int moduleSlot)
+    {
+        if (false == aio.initialized)
+            return ECHO_AIO_NOT_INITIALIZED;
+        if (0 == aio.options.connected)
+            return ECHO_AIO_USB_COMMAND_FAILED;
+        if (moduleSlot < 0 || moduleSlot >= AIO_numModuleSlots)
+            return ECHO_AIO_INVALID_MODULE_SLOT;
+        if (ModuleType::none == aio.modules[moduleSlot].type)
+            return ECHO_AIO_NOT_FOUND;
+        return ECHO_AIO_OK;
+    }
+
+    //
+    // AIO-H and AIO-B modules have no parameters in EchoAIOInterface.h
+    //
+    int checkParameterModule(Emulator& aio, int moduleSlot)
+    {
+        if (int status = checkModule(aio, moduleSlot))
+            return status;
+
+        ModuleType type = aio.modules[moduleSlot].type;
+        if (ModuleType::combo != type && ModuleType::tdm != type)
+            return ECHO_AIO_NOT_SUPPORTED;
+        return ECHO_AIO_OK;
+    }
+
+    void copyText(const std::string& source, char* const text, size_t textBufferBytes)
+    {
+        if (nullptr == text || 0 == textBufferBytes)
+            return;
+
+        size_t count = std::min(source.size(), textBufferBytes - 1);
+        std::memcpy(text, source.data(), count);
+        text[count] = 0;
+    }
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * Emulator configuration
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+int AIOEmulator_setOption(const char* name, const char* value)
+{
+    if (nullptr == name || nullptr == value)
+        return ECHO_AIO_INVALID_PARAMETER;
+
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    Options before = aio.options;
+    int status = setOption(aio.options, name, value);
+    if (ECHO_AIO_OK != status || false == aio.initialized)
+        return status;
+
+    //
+    // Hotplug: a unit that is plugged back in comes up with its settings reset, and a module that is
+    // swapped while the unit is connected comes up with its own settings reset. A short circuit changes
+    // the measurements at once.
+    //
+    if (aio.options.connected && 0 == before.connected)
+    {
+        buildDevice(aio);
+        return status;
+    }
+    for (int slot = 0; slot < AIO_numModuleSlots; ++slot)
+    {
+        if (aio.options.modules[slot] != before.modules[slot])
+            buildModule(aio, slot);
+        updateMeasurements(aio.options, aio.modules[slot]);
+    }
+    return status;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * Library startup and shutdown
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+void AIO_initialize()
+{
+    auto& aio = emulator();
+    Options options;
+    {
+        std::lock_guard<std::mutex> guard(aio.lock);
+        options = aio.options;
+    }
+
+    //
+    // Emulated USB enumeration and module discovery
+    //
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.discoveryMilliseconds));
+
+    std::lock_guard<std::mutex> guard(aio.lock);
+    buildDevice(aio);
+    aio.initialized = true;
+}
+
+void AIO_shutdown()
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    aio.initialized = false;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * Inquiry functions
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+void AIO_getLibraryVersion(char* const text, size_t textBufferBytes)
+{
+    copyText("EchoAIOEmulator 1.0", text, textBufferBytes);
+}
+
+int AIO_isAIOConnected()
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return aio.initialized && aio.options.connected;
+}
+
+int AIO_getNumInputChannels()
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return aio.initialized && aio.options.connected ? static_cast<int>(aio.inputs.size()) : 0;
+}
+
+int AIO_getNumOutputChannels()
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return aio.initialized && aio.options.connected ? static_cast<int>(aio.outputs.size()) : 0;
+}
+
+int AIO_hasComboModule(int moduleSlot)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return ECHO_AIO_OK == checkModule(aio, moduleSlot) && ModuleType::combo == aio.modules[moduleSlot].type;
+}
+
+int AIO_hasTModule(int moduleSlot)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return ECHO_AIO_OK == checkModule(aio, moduleSlot) && ModuleType::tdm == aio.modules[moduleSlot].type;
+}
+
+void AIO_getErrorString(char* const text, size_t textBufferBytes)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    copyText(aio.lastError, text, textBufferBytes);
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * IEPE microphone inputs
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+int AIO_hasInputGainControl(int inputChannel)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return ECHO_AIO_OK == checkInput(aio, inputChannel);
+}
+
+int AIO_getInputGain(int inputChannel, int* const gain)
+{
+    auto& aio = emulator();
+    transfer(aio, inputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkInput(aio, inputChannel))
+        return fail(aio, status);
+    if (nullptr == gain)
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+
+    *gain = aio.inputs[inputChannel].gain;
+    return ECHO_AIO_OK;
+}
+
+int AIO_setInputGain(int inputChannel, int gain)
+{
+    auto& aio = emulator();
+    transfer(aio, inputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkInput(aio, inputChannel))
+        return fail(aio, status);
+    if (gain != 1 && gain != 10 && gain != 100)
+        return fail(aio, ECHO_AIO_INVALID_VALUE);
+
+    aio.inputs[inputChannel].gain = gain;
+    return ECHO_AIO_OK;
+}
+
+int AIO_hasConstantCurrentControl(int inputChannel)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return ECHO_AIO_OK == checkInput(aio, inputChannel);
+}
+
+int AIO_getConstantCurrentState(int inputChannel, int* const enabled)
+{
+    auto& aio = emulator();
+    transfer(aio, inputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkInput(aio, inputChannel))
+        return fail(aio, status);
+    if (nullptr == enabled)
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+
+    *enabled = aio.inputs[inputChannel].constantCurrent;
+    return ECHO_AIO_OK;
+}
+
+int AIO_setConstantCurrentState(int inputChannel, int enabled)
+{
+    auto& aio = emulator();
+    transfer(aio, inputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkInput(aio, inputChannel))
+        return fail(aio, status);
+    if (enabled != 0 && enabled != 1)
+        return fail(aio, ECHO_AIO_INVALID_VALUE);
+
+    aio.inputs[inputChannel].constantCurrent = enabled;
+    return ECHO_AIO_OK;
+}
+
+int AIO_hasTEDS(int inputChannel)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return ECHO_AIO_OK == checkInput(aio, inputChannel) && aio.inputs[inputChannel].teds.size();
+}
+
+int AIO_getTEDSProperties(int inputChannel, char* const jsonText, size_t jsonBufferBytes, size_t* jsonBytesRequired)
+{
+    auto& aio = emulator();
+    transfer(aio, inputLane, Command::teds);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkInput(aio, inputChannel))
+        return fail(aio, status);
+
+    const std::string& teds = aio.inputs[inputChannel].teds;
+    if (teds.empty())
+        return fail(aio, ECHO_AIO_TEDS_DEVICE_NOT_FOUND);
+
+    size_t required = teds.size() + 1;
+    if (jsonBytesRequired)
+        *jsonBytesRequired = required;
+
+    if (nullptr == jsonText)
+        return ECHO_AIO_OK;
+    if (jsonBufferBytes < required)
+        return fail(aio, ECHO_AIO_BUFFER_TOO_SMALL);
+
+    copyText(teds, jsonText, jsonBufferBytes);
+    return ECHO_AIO_OK;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * AMP outputs
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+int AIO_hasOutputGainControl(int outputChannel)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return ECHO_AIO_OK == checkOutput(aio, outputChannel) && aio.options.outputGainControl;
+}
+
+int AIO_getOutputGain(int outputChannel, int* const gain)
+{
+    auto& aio = emulator();
+    transfer(aio, outputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkOutput(aio, outputChannel))
+        return fail(aio, status);
+    if (0 == aio.options.outputGainControl)
+        return fail(aio, ECHO_AIO_NOT_SUPPORTED);
+    if (nullptr == gain)
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+
+    *gain = aio.outputs[outputChannel].gain;
+    return ECHO_AIO_OK;
+}
+
+int AIO_setOutputGain(int outputChannel, int gain)
+{
+    auto& aio = emulator();
+    transfer(aio, outputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkOutput(aio, outputChannel))
+        return fail(aio, status);
+    if (0 == aio.options.outputGainControl)
+        return fail(aio, ECHO_AIO_NOT_SUPPORTED);
+    if (gain < 0 || gain > 255)
+        return fail(aio, ECHO_AIO_INVALID_VALUE);
+
+    aio.outputs[outputChannel].gain = gain;
+    return ECHO_AIO_OK;
+}
+
+int AIO_hasOutputLimitControl(int outputChannel)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return ECHO_AIO_OK == checkOutput(aio, outputChannel);
+}
+
+int AIO_getOutputLimitVolts(int outputChannel, double* const limitVolts)
+{
+    auto& aio = emulator();
+    transfer(aio, outputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkOutput(aio, outputChannel))
+        return fail(aio, status);
+    if (nullptr == limitVolts)
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+
+    *limitVolts = aio.outputs[outputChannel].limitVolts;
+    return ECHO_AIO_OK;
+}
+
+int AIO_setOutputLimitVolts(int outputChannel, double limitVolts)
+{
+    auto& aio = emulator();
+    transfer(aio, outputLane);
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkOutput(aio, outputChannel))
+        return fail(aio, status);
+    if (false == (limitVolts >= 0.0 && limitVolts <= 10.0))
+        return fail(aio, ECHO_AIO_INVALID_VALUE);
+
+    aio.outputs[outputChannel].limitVolts = limitVolts;
+    return ECHO_AIO_OK;
+}
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * Windows audio driver
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+#if _WIN32
+int AIO_getASIOPreferredBufferSize()
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return aio.asioBufferSize;
+}
+
+int AIO_setASIOPreferredBufferSize(int bufferSize)
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (false == aio.initialized)
+        return fail(aio, ECHO_AIO_NOT_INITIALIZED);
+    if (bufferSize < 16 || bufferSize > 4096)
+        return fail(aio, ECHO_AIO_INVALID_VALUE);
+
+    aio.asioBufferSize = bufferSize;
+    return ECHO_AIO_OK;
+}
+
+int AIO_getSampleRate()
+{
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    return aio.sampleRate;
+}
+
+int AIO_setSampleRate(int sampleRate)
+{
+    static const int supportedRates[] = { 44100, 48000, 88200, 96000, 176400, 192000 };
+
+    auto& aio = emulator();
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (false == aio.initialized)
+        return fail(aio, ECHO_AIO_NOT_INITIALIZED);
+    if (std::end(supportedRates) == std::find(std::begin(supportedRates), std::end(supportedRates), sampleRate))
+        return fail(aio, ECHO_AIO_INVALID_VALUE);
+
+    aio.sampleRate = sampleRate;
+    return ECHO_AIO_OK;
+}
+#endif
+
+
+/*-----------------------------------------------------------------------------------------------------------------
+ *
+ * Module parameters
+ *
+ *---------------------------------------------------------------------------------------------------------------*/
+
+int AIO_getModuleIntParameter(int moduleSlot, int parameter, int* const value)
+{
+    auto& aio = emulator();
+    transfer(aio, slotLane(moduleSlot));
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkParameterModule(aio, moduleSlot))
+        return fail(aio, status);
+
+    Module& module = aio.modules[moduleSlot];
+    auto found = module.intParameters.find(parameter);
+    if (module.intParameters.end() == found || nullptr == value)
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+    if (aio.options.auxLoopback && AIO_COMBO_MODULE_PARAMETER_AUX_IN == parameter)
+        found = module.intParameters.find(AIO_COMBO_MODULE_PARAMETER_AUX_OUT);
+
+    *value = found->second;
+    return ECHO_AIO_OK;
+}
+
+int AIO_setModuleIntParameter(int moduleSlot, int parameter, int value)
+{
+    auto& aio = emulator();
+    transfer(aio, slotLane(moduleSlot));
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkParameterModule(aio, moduleSlot))
+        return fail(aio, status);
+
+    Module& module = aio.modules[moduleSlot];
+    auto found = module.intParameters.find(parameter);
+    if (module.intParameters.end() == found || isReadOnly(parameter))
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+    if (int status = validateIntValue(module, parameter, value))
+        return fail(aio, status);
+
+    found->second = value;
+    updateMeasurements(aio.options, module);
+    return ECHO_AIO_OK;
+}
+
+int AIO_getModuleDoubleParameter(int moduleSlot, int parameter, double* const value)
+{
+    auto& aio = emulator();
+    transfer(aio, slotLane(moduleSlot));
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkParameterModule(aio, moduleSlot))
+        return fail(aio, status);
+
+    Module& module = aio.modules[moduleSlot];
+    auto found = module.doubleParameters.find(parameter);
+    if (module.doubleParameters.end() == found || nullptr == value)
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+
+    *value = found->second;
+    return ECHO_AIO_OK;
+}
+
+int AIO_setModuleDoubleParameter(int moduleSlot, int parameter, double value)
+{
+    auto& aio = emulator();
+    transfer(aio, slotLane(moduleSlot));
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkParameterModule(aio, moduleSlot))
+        return fail(aio, status);
+
+    Module& module = aio.modules[moduleSlot];
+    auto found = module.doubleParameters.find(parameter);
+    if (module.doubleParameters.end() == found || isReadOnly(parameter))
+        return fail(aio, ECHO_AIO_INVALID_PARAMETER);
+
+    double range = currentRangeAmps(module.intParameters[AIO_COMBO_MODULE_PARAMETER_MEASURED_CURRENT_RANGE]);
+    if (false == (value > 0.0 && value <= range))
+        return fail(aio, ECHO_AIO_INVALID_VALUE);
+
+    found->second = value;
+    updateMeasurements(aio.options, module);
+    return ECHO_AIO_OK;
+}
+
+int AIO_updateTDM(int moduleSlot)
+{
+    auto& aio = emulator();
+    transfer(aio, slotLane(moduleSlot));
+    std::lock_guard<std::mutex> guard(aio.lock);
+    if (int status = checkModule(aio, moduleSlot))
+        return fail(aio, status);
+    if (ModuleType::tdm != aio.modules[moduleSlot].type)
+        return fail(aio, ECHO_AIO_NOT_SUPPORTED);
+
+    return ECHO_AIO_OK;
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    EchoAIOEmulator - emulated AIO backend exports
+
+    The emulator builds as a drop-in replacement for the EchoAIOInterface
+    library. It implements every function in EchoAIOInterface.h against a
+    virtual AIO and adds the configuration export below.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../../EchoAIOInterface.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /*
+        AIOEmulator_setOption
+
+        Parameters
+            name            Option name (see below)
+            value           Option value as zero-terminated text
+
+        Options take effect on the next AIO_initialize. Every option may also be set from the environment
+        before the library loads; the environment variable name is ECHO_AIO_EMULATOR_ followed by the option
+        name in upper case (e.g. ECHO_AIO_EMULATOR_DISCOVERYMILLISECONDS).
+
+        Options
+            discoveryMilliseconds   Time AIO_initialize spends on emulated USB enumeration and module discovery
+            commandMicroseconds     Round-trip time of each emulated USB command (getters, setters, TEDS reads);
+                                    takes effect immediately
+            commandJitterMicroseconds
+                                    Uniformly distributed extra time, from zero up to this value, added to each
+                                    emulated USB command; takes effect immediately
+            tedsMicroseconds        Round-trip time of a TEDS read, if different from commandMicroseconds (-1, the
+                                    default, uses commandMicroseconds); takes effect immediately
+            seed                    Seed for the jitter random number generator
+            serialNumber            Serial number reported by the AIO-C module; use a different value for each
+                                    emulated unit loaded into one process
+            inputChannels           Number of input channels (default 4, at most 32)
+            outputChannels          Number of output channels (default 2, at most 32)
+            outputGainControl       1 to give the outputs a gain control (0 - 255); by default AIO_getOutputGain
+                                    and AIO_setOutputGain return ECHO_AIO_NOT_SUPPORTED
+            auxLoopback             1 to wire each AIO-C module's AUX OUT pins back to its AUX IN pins, so AUX IN
+                                    reads the last value set for AUX OUT
+            commandLanes            How emulated USB commands overlap: 0 (the default) lets every command overlap; 1
+                                    runs one command at a time, like a library that serializes every call behind one
+                                    lock; 2 gives the input channels, the output channels, and each module slot a
+                                    lane of their own, and runs one command at a time per lane. Takes effect
+                                    immediately
+            connected               0 unplugs the unit: AIO_isAIOConnected returns 0, the channel counts are 0,
+                                    no modules are reported, and other calls return ECHO_AIO_USB_COMMAND_FAILED.
+                                    1 (the default) plugs it back in with its settings reset. Takes effect
+                                    immediately
+            shortCircuit            1 shorts the variable DC supply of each AIO-C module: while the supply is enabled,
+                                    the measured current reads the top of the measurement range, which trips the over
+                                    current condition if it is above the threshold. The condition stays set until it
+                                    is cleared, and clearing it while the short remains trips it again. Takes effect
+                                    immediately
+            modules                 One letter per module slot: C (AIO-C), T (AIO-T), H (AIO-H), B (AIO-B), or
+                                    - for an empty slot. The default is CT. AIO-H and AIO-B modules report no
+                                    parameters; their parameter calls return ECHO_AIO_NOT_SUPPORTED. Changing the
+                                    letter of a slot after AIO_initialize swaps the module in that slot, leaving
+                                    the other slot as it is
+            teds<N>                 TEDS JSON text for input channel N (e.g. teds0); an empty value removes the
+                                    TEDS. By default channels 0 and 1 have a TEDS and the others do not.
+
+        Returns 0 if successful, ECHO_AIO_INVALID_PARAMETER for an unknown name, or ECHO_AIO_INVALID_VALUE
+    */
+    ECHO_AIO_API int AIOEmulator_setOption(const char* name, const char* value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,59 +1,46 @@
 #include <iostream>
-#include <Windows.h>
-#include "../../EchoAIOInterface.h"
+#include <string>
+#include "../Common/AIOApi.h"
 
 void libraryAccessDemo(HMODULE handle)
 {
     //
-    // Always call AIO_initialize first
+    // Look up every library function once; after this, each call is a single indirect call
     //
-    auto pAIO_initialize = GetProcAddress(handle, "AIO_initialize");
-    if (pAIO_initialize)
-    {
-        pAIO_initialize();
-    }
-    else
+    AIOApi api;
+    std::string error;
+    if (false == api.resolve(handle, error))
     {
-        std::cout << "Unable to find AIO_initialize function";
+        std::cout << error;
         return;
     }
 
+    std::cout << "Echo AIO library version " << api.libraryVersion << std::endl;
+
     //
-    // Read the input gain setting
+    // Always call AIO_initialize first
     //
-    using AIO_getInputGainPointer = int (*)(int, int* const);
+    api.AIO_initialize();
 
+    //
+    // Read the input gain setting
+    //
     int inputChannel = 0; // MIC1
-    auto pAIO_getInputGain = reinterpret_cast<AIO_getInputGainPointer>(GetProcAddress(handle, "AIO_getInputGain"));
-    if (pAIO_getInputGain)
+    int gain = 0;
+    int status = api.AIO_getInputGain(inputChannel, &gain);
+    if (ECHO_AIO_OK == status)
     {
-        int gain = 0;
-        int status = pAIO_getInputGain(inputChannel, &gain);
-        if (ECHO_AIO_OK == status)
-        {
-            std::cout << "Input channel " << inputChannel + 1 << " gain is " << gain;
-        }
-        else
-        {
-            std::cout << "Unable to read input gain; error " << status;
-        }
+        std::cout << "Input channel " << inputChannel + 1 << " gain is " << gain;
     }
     else
     {
-        std::cout << "Unable to find AIO_getInputGain function";
+        std::cout << "Unable to read input gain; error " << status;
     }
 
     //
     // Always call AIO_shutdown before unloading the DLL
     //
-    if (auto pAIO_shutdown = GetProcAddress(handle, "AIO_shutdown"))
-    {
-        pAIO_shutdown();
-    }
-    else
-    {
-        std::cout << "Unable to find AIO_shutdown function";
-    }
+    api.AIO_shutdown();
 }
 
 int main()
@@ -72,7 +59,7 @@ int main()
     // Access the DLL
     //
     libraryAccessDemo(handle);
-    
+
     //
     // Unload the DLL
     //
@@ -1,61 +1,46 @@
 #include <iostream>
-#include <dlfcn.h>
-#include "../../EchoAIOInterface.h"
+#include <string>
+#include "../Common/AIOApi.h"
 
-void libraryAccessDemo(void* handle)
+void libraryAccessDemo(AIOLibraryHandle handle)
 {
     //
-    // Always call AIO_initialize first
+    // Look up every library function once; after this, each call is a single indirect call
     //
-    using AIO_initializePointer = void (*)();
-    auto pAIO_initialize = reinterpret_cast<AIO_initializePointer>(dlsym(handle, "AIO_initialize"));
-    if (pAIO_initialize)
-    {
-        pAIO_initialize();
-    }
-    else
+    AIOApi api;
+    std::string error;
+    if (false == api.resolve(handle, error))
     {
-        std::cout << "Unable to find AIO_initialize function";
+        std::cout << error;
         return;
     }
 
+    std::cout << "Echo AIO library version " << api.libraryVersion << std::endl;
+
     //
-    // Read the input gain setting
+    // Always call AIO_initialize first
     //
-    using AIO_getInputGainPointer = int (*)(int, int* const);
+    api.AIO_initialize();
 
+    //
+    // Read the input gain setting
+    //
     int inputChannel = 0; // MIC1
-    auto pAIO_getInputGain = reinterpret_cast<AIO_getInputGainPointer>(dlsym(handle, "AIO_getInputGain"));
-    if (pAIO_getInputGain)
+    int gain = 0;
+    int status = api.AIO_getInputGain(inputChannel, &gain);
+    if (ECHO_AIO_OK == status)
     {
-        int gain = 0;
-        int status = pAIO_getInputGain(inputChannel, &gain);
-        if (ECHO_AIO_OK == status)
-        {
-            std::cout << "Input channel " << inputChannel + 1 << " gain is " << gain;
-        }
-        else
-        {
-            std::cout << "Unable to read input gain; error " << status;
-        }
+        std::cout << "Input channel " << inputChannel + 1 << " gain is " << gain;
     }
     else
     {
-        std::cout << "Unable to find AIO_getInputGain function";
+        std::cout << "Unable to read input gain; error " << status;
     }
 
     //
-    // Always call AIO_shutdown before unloading the DLL
+    // Always call AIO_shutdown before unloading the dynamic library
     //
-    using AIO_shutdownPointer = void (*)();
-    if (auto pAIO_shutdown = reinterpret_cast<AIO_shutdownPointer>(dlsym(handle, "AIO_shutdown")))
-    {
-        pAIO_shutdown();
-    }
-    else
-    {
-        std::cout << "Unable to find AIO_shutdown function";
-    }
+    api.AIO_shutdown();
 }
 
 int main(int /*argc*/, const char * /*argv*/ [])
@@ -63,7 +48,7 @@ int main(int /*argc*/, const char * /*argv*/ [])
     //
     // Load the dynamic library; assume the library is in the same folder as this app
     //
-    auto handle = dlopen("EchoAIOInterface.dylib", RTLD_LOCAL | RTLD_NOW);
+    auto handle = AIOApi::openLibrary(AIOApi::defaultLibraryName);
     if (nullptr == handle)
     {
         std::cout << "Unable to load Echo AIO library";
@@ -78,7 +63,7 @@ int main(int /*argc*/, const char * /*argv*/ [])
     //
     // Unload the dynamic library
     //
-    dlclose(handle);
+    AIOApi::closeLibrary(handle);
     
     return 0;
 }
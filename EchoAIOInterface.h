@@ -24,6 +24,14 @@
 #endif
 #endif
 
+#ifdef __linux__
+#if ECHO_AIO_EXPORTS
+#define ECHO_AIO_API __attribute__((visibility("default")))
+#else
+#define ECHO_AIO_API
+#endif
+#endif
+
 
 
 /*-----------------------------------------------------------------------------------------------------------------
@@ -45,6 +53,7 @@
 #define ECHO_AIO_NOT_SUPPORTED 10
 #define ECHO_AIO_TEDS_DEVICE_NOT_FOUND 11
 #define ECHO_AIO_INVALID_VALUE 12
+#define ECHO_AIO_TIMEOUT 13
 
 #ifdef __cplusplus
 extern "C"